@@ -0,0 +1,179 @@
+#ifndef LAB_1_ASSEMBLYPIPELINE_H
+#define LAB_1_ASSEMBLYPIPELINE_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+
+#include "Bench.h"
+
+
+//Single-producer single-consumer ring buffer joining two stations.
+//Capacity is rounded up to a power of two; head and tail are padded onto separate cache lines.
+template <class T>
+class SpscRing{
+private:
+    vector<T> slots;
+    size_t mask;
+    char padHead[64];
+    atomic<size_t> head{0};
+    char padTail[64];
+    atomic<size_t> tail{0};
+
+public:
+    explicit SpscRing(size_t capacity)
+    {
+        size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    bool tryPush(const T& item)
+    {
+        size_t t = tail.load(memory_order_relaxed);
+        if (t - head.load(memory_order_acquire) == slots.size())
+            return false;
+        slots[t & mask] = item;
+        tail.store(t + 1, memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& item)
+    {
+        size_t h = head.load(memory_order_relaxed);
+        if (h == tail.load(memory_order_acquire))
+            return false;
+        item = slots[h & mask];
+        head.store(h + 1, memory_order_release);
+        return true;
+    }
+
+    void push(const T& item)
+    {
+        while (!tryPush(item))
+            this_thread::yield();
+    }
+
+    T pop()
+    {
+        T item;
+        while (!tryPop(item))
+            this_thread::yield();
+        return item;
+    }
+};
+
+
+//Busy-waits to stand in for the time a cook spends at a station
+void simulateStationWork(chrono::nanoseconds time)
+{
+    spinFor(time);
+}
+
+
+//Buns -> patty -> toppings -> sauce, one thread per station.
+//Several burgers are in progress at once, one at each station.
+class AssemblyPipeline{
+private:
+    typedef void (IBurger::*Step)();
+
+    chrono::nanoseconds stationTime;
+    size_t ringCapacity;
+
+    void station(Step step, SpscRing<IBurger*>& in, SpscRing<IBurger*>* out)
+    {
+        while (true)
+        {
+            IBurger* burger = in.pop();
+            if (burger == nullptr)
+            {
+                if (out)
+                    out->push(nullptr);
+                return;
+            }
+            (burger->*step)();
+            simulateStationWork(stationTime);
+            if (out)
+                out->push(burger);
+        }
+    }
+
+public:
+    explicit AssemblyPipeline(chrono::nanoseconds time = chrono::nanoseconds(0), size_t capacity = 1024)
+    {
+        stationTime = time;
+        ringCapacity = capacity;
+    }
+
+    //Feeds every order through the stations and returns the elapsed seconds
+    double run(const vector<IBurger*>& orders)
+    {
+        const Step steps[] = {&IBurger::addBuns, &IBurger::addPatty, &IBurger::addToppings, &IBurger::addSauce};
+        const size_t stationCount = sizeof(steps) / sizeof(steps[0]);
+
+        vector<unique_ptr<SpscRing<IBurger*>>> rings;
+        for (size_t i = 0; i < stationCount; i++)
+            rings.emplace_back(new SpscRing<IBurger*>(ringCapacity));
+
+        Stopwatch clock;
+        vector<thread> stations;
+        for (size_t i = 0; i < stationCount; i++)
+        {
+            SpscRing<IBurger*>* out = i + 1 < stationCount ? rings[i + 1].get() : nullptr;
+            stations.emplace_back(&AssemblyPipeline::station, this, steps[i], ref(*rings[i]), out);
+        }
+
+        for (auto burger : orders)
+            rings[0]->push(burger);
+        rings[0]->push(nullptr);
+
+        for (auto& t : stations)
+            t.join();
+        return clock.seconds();
+    }
+
+    //Baseline: one cook makes each order from start to finish
+    double runWholeOrders(const vector<IBurger*>& orders)
+    {
+        Stopwatch clock;
+        for (auto burger : orders)
+        {
+            burger->makeBurger();
+            simulateStationWork(stationTime * 4);
+        }
+        return clock.seconds();
+    }
+};
+
+
+void AssemblyPipelineDemo()
+{
+    Hamburger hamburger;
+    Cheeseburger cheeseburger;
+    Crispychickenburger crispychickenburger;
+
+    vector<IBurger*> menu = {&hamburger, &cheeseburger, &crispychickenburger};
+    vector<IBurger*> orders;
+    for (size_t i = 0; i < 20000; i++)
+        orders.push_back(menu[i % menu.size()]);
+
+    cout<<"Hardware threads: "<<thread::hardware_concurrency()<<endl;
+    for (long ns : {0L, 2000L})
+    {
+        AssemblyPipeline pipeline{chrono::nanoseconds(ns)};
+        double whole, piped;
+        {
+            MuteCout mute;
+            whole = pipeline.runWholeOrders(orders);
+            piped = pipeline.run(orders);
+        }
+        cout<<"Station time "<<ns<<" ns: whole orders "<<(uint64_t)(orders.size() / whole)<<" orders/s, "
+            <<"pipeline "<<(uint64_t)(orders.size() / piped)<<" orders/s, "
+            <<"gain x"<<whole / piped<<endl;
+    }
+}
+
+#endif //LAB_1_ASSEMBLYPIPELINE_H
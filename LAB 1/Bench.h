@@ -0,0 +1,66 @@
+#ifndef LAB_1_BENCH_H
+#define LAB_1_BENCH_H
+
+#include <chrono>
+
+
+class Stopwatch{
+private:
+    chrono::steady_clock::time_point start;
+public:
+    Stopwatch()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        start = chrono::steady_clock::now();
+    }
+
+    double seconds() const
+    {
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+};
+
+
+//Busy-waits to stand in for real work
+void spinFor(chrono::nanoseconds time)
+{
+    if (time.count() <= 0)
+        return;
+    auto until = chrono::steady_clock::now() + time;
+    while (chrono::steady_clock::now() < until);
+}
+
+
+//Makes the compiler treat the value as used and memory as changed, so benchmarked work is
+//neither dropped nor folded across loop iterations
+template <class T>
+void doNotOptimize(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+
+//Silences cout while in scope, so the recipes can be run in bulk without flooding the console.
+//Create it before starting any worker threads and destroy it after joining them.
+class MuteCout{
+private:
+    streambuf* saved;
+public:
+    MuteCout()
+    {
+        saved = cout.rdbuf(nullptr);
+    }
+
+    MuteCout(const MuteCout&) = delete;
+
+    ~MuteCout()
+    {
+        cout.rdbuf(saved);
+    }
+};
+
+#endif //LAB_1_BENCH_H
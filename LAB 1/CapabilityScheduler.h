@@ -0,0 +1,358 @@
+#ifndef LAB_1_CAPABILITYSCHEDULER_H
+#define LAB_1_CAPABILITYSCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "Bench.h"
+
+
+enum Capability{
+    BACKEND,
+    FRONTEND,
+    DEVOPS,
+    NETWORK,
+    CAPABILITY_COUNT
+};
+
+const char* capabilityName(Capability capability)
+{
+    static const char* names[CAPABILITY_COUNT] = {"backend", "frontend", "devops", "network"};
+    return names[capability];
+}
+
+struct DevTask{
+    Capability need;
+    uint32_t id;
+};
+
+
+//An employee seen through the role interfaces it implements
+class RoleWorker{
+private:
+    IBackend* backend = nullptr;
+    IFrontend* frontend = nullptr;
+    IDevOps* devOps = nullptr;
+    INetwork* network = nullptr;
+
+public:
+    string name;
+
+    template <class Employee>
+    RoleWorker(string n, Employee* employee)
+    {
+        name = n;
+        backend = dynamic_cast<IBackend*>(employee);
+        frontend = dynamic_cast<IFrontend*>(employee);
+        devOps = dynamic_cast<IDevOps*>(employee);
+        network = dynamic_cast<INetwork*>(employee);
+    }
+
+    bool can(Capability capability) const
+    {
+        switch (capability)
+        {
+            case BACKEND:
+                return backend != nullptr;
+            case FRONTEND:
+                return frontend != nullptr;
+            case DEVOPS:
+                return devOps != nullptr;
+            case NETWORK:
+                return network != nullptr;
+            default:
+                return false;
+        }
+    }
+
+    void perform(Capability capability)
+    {
+        switch (capability)
+        {
+            case BACKEND:
+                backend->codeBackend();
+                break;
+            case FRONTEND:
+                frontend->codeFrontend();
+                break;
+            case DEVOPS:
+                devOps->deployApp();
+                break;
+            case NETWORK:
+                network->developNetwork();
+                break;
+            default:
+                break;
+        }
+    }
+};
+
+
+struct WorkerStats{
+    string name;
+    string home;
+    uint64_t done = 0;
+    uint64_t stolen = 0;
+    double busySeconds = 0;
+};
+
+
+//One queue per capability. Every worker has a home queue among the roles it implements and,
+//when that runs dry, steals from the longest other queue it is able to serve.
+//Homes are spread so each capability gets as many workers as possible.
+class CapabilityScheduler{
+private:
+    struct Queue{
+        mutex lock;
+        deque<DevTask> tasks;
+        atomic<size_t> size{0};
+    };
+
+    struct Worker{
+        RoleWorker roles;
+        Capability home;
+        atomic<uint64_t> done{0};
+        atomic<uint64_t> stolen{0};
+        atomic<uint64_t> busyNanos{0};
+
+        Worker(const RoleWorker& r, Capability h) : roles(r)
+        {
+            home = h;
+        }
+    };
+
+    Queue queues[CAPABILITY_COUNT];
+    vector<unique_ptr<Worker>> workers;
+    vector<thread> threads;
+    bool stealing;
+    chrono::nanoseconds taskTime;
+
+    atomic<bool> stopping{false};
+    atomic<size_t> queued{0};
+    atomic<size_t> pending{0};
+    atomic<int> sleeping{0};
+    mutex wakeLock;
+    condition_variable wakeUp;
+    mutex doneLock;
+    condition_variable allDone;
+
+    bool pop(Capability capability, DevTask& task)
+    {
+        Queue& q = queues[capability];
+        if (q.size.load(memory_order_relaxed) == 0)
+            return false;
+        lock_guard<mutex> guard(q.lock);
+        if (q.tasks.empty())
+            return false;
+        task = q.tasks.front();
+        q.tasks.pop_front();
+        q.size.fetch_sub(1, memory_order_relaxed);
+        return true;
+    }
+
+    bool next(Worker& w, DevTask& task)
+    {
+        if (pop(w.home, task))
+            return true;
+        if (!stealing)
+            return false;
+
+        while (true)
+        {
+            int longest = -1;
+            size_t longestSize = 0;
+            for (int c = 0; c < CAPABILITY_COUNT; c++)
+            {
+                size_t size = queues[c].size.load(memory_order_relaxed);
+                if (c != w.home && size > longestSize && w.roles.can(Capability(c)))
+                {
+                    longest = c;
+                    longestSize = size;
+                }
+            }
+            if (longest < 0)
+                return false;
+            if (pop(Capability(longest), task))
+            {
+                w.stolen.fetch_add(1, memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+
+    bool hasWork(const Worker& w)
+    {
+        for (int c = 0; c < CAPABILITY_COUNT; c++)
+            if ((c == w.home || (stealing && w.roles.can(Capability(c)))) && queues[c].size.load() > 0)
+                return true;
+        return false;
+    }
+
+    void work(Worker& w)
+    {
+        while (true)
+        {
+            DevTask task;
+            if (next(w, task))
+            {
+                queued.fetch_sub(1);
+                auto start = chrono::steady_clock::now();
+                w.roles.perform(task.need);
+                spinFor(taskTime);
+                w.busyNanos.fetch_add(uint64_t(chrono::duration_cast<chrono::nanoseconds>(
+                        chrono::steady_clock::now() - start).count()), memory_order_relaxed);
+                w.done.fetch_add(1, memory_order_relaxed);
+                if (pending.fetch_sub(1) == 1)
+                {
+                    lock_guard<mutex> guard(doneLock);
+                    allDone.notify_all();
+                }
+                continue;
+            }
+
+            unique_lock<mutex> guard(wakeLock);
+            sleeping.fetch_add(1);
+            wakeUp.wait(guard, [&]{ return stopping.load() || hasWork(w); });
+            sleeping.fetch_sub(1);
+            if (stopping.load() && !hasWork(w))
+                return;
+        }
+    }
+
+public:
+    //taskTime is busy work added to every task, standing in for the time the job really takes
+    CapabilityScheduler(const vector<RoleWorker>& team, bool steal = true,
+                        chrono::nanoseconds time = chrono::nanoseconds(0))
+    {
+        stealing = steal;
+        taskTime = time;
+
+        size_t homed[CAPABILITY_COUNT] = {};
+        for (auto& member : team)
+        {
+            int home = -1;
+            for (int c = 0; c < CAPABILITY_COUNT; c++)
+                if (member.can(Capability(c)) && (home < 0 || homed[c] < homed[home]))
+                    home = c;
+            if (home < 0)
+                continue;
+            homed[home]++;
+            workers.emplace_back(new Worker(member, Capability(home)));
+        }
+        for (auto& w : workers)
+            threads.emplace_back(&CapabilityScheduler::work, this, ref(*w));
+    }
+
+    CapabilityScheduler(const CapabilityScheduler&) = delete;
+
+    ~CapabilityScheduler()
+    {
+        waitIdle();
+        {
+            lock_guard<mutex> guard(wakeLock);
+            stopping = true;
+        }
+        wakeUp.notify_all();
+        for (auto& t : threads)
+            t.join();
+    }
+
+    //Returns false if nobody on the team will take the task: nobody implements the capability,
+    //or, without stealing, it is nobody's home queue
+    bool submit(DevTask task)
+    {
+        bool served = false;
+        for (auto& w : workers)
+            served = served || (stealing ? w->roles.can(task.need) : w->home == task.need);
+        if (!served)
+            return false;
+
+        pending.fetch_add(1);
+        queued.fetch_add(1);
+        {
+            Queue& q = queues[task.need];
+            lock_guard<mutex> guard(q.lock);
+            q.tasks.push_back(task);
+            q.size.fetch_add(1);
+        }
+        if (sleeping.load() > 0)
+        {
+            { lock_guard<mutex> guard(wakeLock); }
+            wakeUp.notify_all();
+        }
+        return true;
+    }
+
+    void waitIdle()
+    {
+        unique_lock<mutex> guard(doneLock);
+        allDone.wait(guard, [this]{ return pending.load() == 0; });
+    }
+
+    vector<WorkerStats> stats() const
+    {
+        vector<WorkerStats> result;
+        for (auto& w : workers)
+        {
+            WorkerStats s;
+            s.name = w->roles.name;
+            s.home = capabilityName(w->home);
+            s.done = w->done.load();
+            s.stolen = w->stolen.load();
+            s.busySeconds = w->busyNanos.load() / 1e9;
+            result.push_back(s);
+        }
+        return result;
+    }
+};
+
+
+void CapabilitySchedulerDemo()
+{
+    FullStackDev alice, bob;
+    DevOpsEngineer carol;
+    NetworkArchitect dave;
+    vector<RoleWorker> team = {
+            RoleWorker("FullStackDev Alice", &alice),
+            RoleWorker("FullStackDev Bob", &bob),
+            RoleWorker("DevOpsEngineer Carol", &carol),
+            RoleWorker("NetworkArchitect Dave", &dave)
+    };
+
+    //Skewed sprint: mostly backend work
+    vector<DevTask> tasks;
+    for (uint32_t i = 0; i < 2000; i++)
+    {
+        uint32_t roll = i % 20;
+        Capability need = roll < 14 ? BACKEND : (roll < 17 ? FRONTEND : (roll < 19 ? DEVOPS : NETWORK));
+        tasks.push_back(DevTask{need, i});
+    }
+
+    for (bool steal : {false, true})
+    {
+        double seconds;
+        vector<WorkerStats> stats;
+        {
+            MuteCout mute;
+            Stopwatch clock;
+            CapabilityScheduler scheduler(team, steal, chrono::microseconds(50));
+            for (auto& task : tasks)
+                scheduler.submit(task);
+            scheduler.waitIdle();
+            seconds = clock.seconds();
+            stats = scheduler.stats();
+        }
+
+        cout<<(steal ? "With stealing: " : "Home queues only: ")<<tasks.size()<<" tasks in "<<seconds<<" s"<<endl;
+        for (auto& s : stats)
+            cout<<"  "<<s.name<<" (home "<<s.home<<"): "<<s.done<<" tasks, "<<s.stolen<<" stolen, busy "
+                <<(uint64_t)(s.busySeconds * 1000)<<" ms"<<endl;
+    }
+}
+
+#endif //LAB_1_CAPABILITYSCHEDULER_H
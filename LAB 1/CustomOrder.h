@@ -0,0 +1,290 @@
+#ifndef LAB_1_CUSTOMORDER_H
+#define LAB_1_CUSTOMORDER_H
+
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "Bench.h"
+
+
+static_assert(INGREDIENT_COUNT <= 8, "CustomOrder packs ingredients into 8-bit masks");
+
+//A base burger plus modifications, packed into one integer:
+//bits 0-15 base burger, 16-23 ingredients removed, 24-31 ingredients with one extra portion
+class CustomOrder{
+private:
+    uint32_t bits;
+
+    static uint32_t maskOf(Ingredient ingredient)
+    {
+        return 1u << ingredient;
+    }
+
+public:
+    explicit CustomOrder(uint16_t base)
+    {
+        bits = base;
+    }
+
+    CustomOrder& without(Ingredient ingredient)
+    {
+        bits |= maskOf(ingredient) << 16;
+        return *this;
+    }
+
+    CustomOrder& extra(Ingredient ingredient)
+    {
+        bits |= maskOf(ingredient) << 24;
+        return *this;
+    }
+
+    uint16_t base() const
+    {
+        return uint16_t(bits & 0xFFFF);
+    }
+
+    uint32_t removed() const
+    {
+        return (bits >> 16) & 0xFF;
+    }
+
+    uint32_t extras() const
+    {
+        return (bits >> 24) & 0xFF;
+    }
+
+    //The same order with the given modifications
+    CustomOrder with(uint32_t removed, uint32_t extras) const
+    {
+        CustomOrder order(base());
+        order.bits |= (removed & 0xFF) << 16 | (extras & 0xFF) << 24;
+        return order;
+    }
+
+    uint32_t key() const
+    {
+        return bits;
+    }
+};
+
+
+//The resolved recipe of one custom order: a label and the ingredient steps laid out
+//station by station, so assembling it is a linear walk.
+class AssemblyPlan : public IBurger
+{
+private:
+    string label;
+    Recipe ingredients;
+    vector<Ingredient> steps;
+    size_t stationBegin[STATION_COUNT + 1] = {};
+
+    void addStation(Station station)
+    {
+        for (size_t i = stationBegin[station]; i < stationBegin[station + 1]; i++)
+            cout<<"Adding "<<ingredientName(steps[i])<<endl;
+    }
+
+public:
+    AssemblyPlan(const string& name, const Recipe& recipe)
+    {
+        label = name;
+        ingredients = recipe;
+        for (int s = 0; s < STATION_COUNT; s++)
+        {
+            stationBegin[s] = steps.size();
+            for (int i = 0; i < INGREDIENT_COUNT; i++)
+                if (stationOf(Ingredient(i)) == s)
+                    steps.insert(steps.end(), recipe.amount[i], Ingredient(i));
+        }
+        stationBegin[STATION_COUNT] = steps.size();
+    }
+
+    const string& getLabel() const
+    {
+        return label;
+    }
+
+    void makeBurger() override
+    {
+        cout<<"Making "<<label<<endl;
+        addBuns();
+        addPatty();
+        addToppings();
+        addSauce();
+    }
+
+    void addBuns() override
+    {
+        addStation(BUN_STATION);
+    }
+
+    void addPatty() override
+    {
+        addStation(GRILL);
+    }
+
+    void addToppings() override
+    {
+        addStation(TOPPING_STATION);
+    }
+
+    void addSauce() override
+    {
+        addStation(SAUCE_STATION);
+    }
+
+    Recipe recipe() const override
+    {
+        return ingredients;
+    }
+};
+
+
+//Plans custom orders on top of the IBurger base types and remembers every plan by its order key,
+//so a repeated custom order costs one hash lookup. Orders that differ only in removing something
+//the burger does not have share a plan. Not thread-safe; give each cook its own planner.
+class CustomOrderPlanner{
+private:
+    vector<IBurger*> bases;
+    vector<string> baseNames;
+    vector<uint32_t> baseIngredients;
+    unordered_map<uint32_t, AssemblyPlan> plans;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    void checkBase(const CustomOrder& order) const
+    {
+        if (order.base() >= bases.size())
+            throw out_of_range("CustomOrderPlanner: unknown base burger " + to_string(order.base()));
+    }
+
+public:
+    //Throws length_error past the 65536 bases an order can name
+    uint16_t addBase(IBurger* burger, const string& name)
+    {
+        if (bases.size() > UINT16_MAX)
+            throw length_error("CustomOrderPlanner: too many base burgers");
+        Recipe recipe = burger->recipe();
+        uint32_t present = 0;
+        for (int i = 0; i < INGREDIENT_COUNT; i++)
+            if (recipe.amount[i] > 0)
+                present |= 1u << i;
+        bases.push_back(burger);
+        baseNames.push_back(name);
+        baseIngredients.push_back(present);
+        return uint16_t(bases.size() - 1);
+    }
+
+    //Drops removals of ingredients the base does not have, which change nothing.
+    //A removal wins over an extra portion of the same ingredient.
+    //normalize, makePlan and plan throw out_of_range for a base that was never added.
+    CustomOrder normalize(const CustomOrder& order) const
+    {
+        checkBase(order);
+        uint32_t removed = order.removed() & baseIngredients[order.base()];
+        return order.with(removed, order.extras() & ~removed);
+    }
+
+    //Works the plan out from scratch
+    AssemblyPlan makePlan(const CustomOrder& order) const
+    {
+        checkBase(order);
+        Recipe recipe = bases[order.base()]->recipe();
+        string label = baseNames[order.base()];
+        for (int i = 0; i < INGREDIENT_COUNT; i++)
+        {
+            uint32_t bit = 1u << i;
+            if ((order.removed() & bit) && recipe.amount[i] > 0)
+            {
+                recipe.amount[i] = 0;
+                label += string(", no ") + ingredientName(Ingredient(i));
+            }
+            else if (order.extras() & bit)
+            {
+                recipe.add(Ingredient(i));
+                label += string(", extra ") + ingredientName(Ingredient(i));
+            }
+        }
+        return AssemblyPlan(label, recipe);
+    }
+
+    AssemblyPlan& plan(const CustomOrder& requested)
+    {
+        CustomOrder order = normalize(requested);
+        auto found = plans.find(order.key());
+        if (found != plans.end())
+        {
+            hits++;
+            return found->second;
+        }
+        misses++;
+        return plans.emplace(order.key(), makePlan(order)).first->second;
+    }
+
+    size_t cachedPlans() const
+    {
+        return plans.size();
+    }
+
+    uint64_t cacheHits() const
+    {
+        return hits;
+    }
+
+    uint64_t cacheMisses() const
+    {
+        return misses;
+    }
+};
+
+
+void CustomOrderDemo()
+{
+    Hamburger hamburger;
+    Cheeseburger cheeseburger;
+    Crispychickenburger crispychickenburger;
+
+    CustomOrderPlanner planner;
+    uint16_t ham = planner.addBase(&hamburger, "Hamburger");
+    uint16_t cheese = planner.addBase(&cheeseburger, "Cheeseburger");
+    uint16_t chicken = planner.addBase(&crispychickenburger, "CrispyChickenBurger");
+
+    cout<<endl;
+    planner.plan(CustomOrder(cheese).without(CHEESE).extra(BEEF_PATTY)).makeBurger();
+    cout<<endl;
+    planner.plan(CustomOrder(chicken).without(TOMATO).extra(CHEESE)).makeBurger();
+
+    //Random modifications of the three base burgers, repeated many times
+    mt19937 gen(3);
+    vector<CustomOrder> orders;
+    for (size_t i = 0; i < 200000; i++)
+    {
+        CustomOrder order(uint16_t(gen() % 3 == 0 ? ham : (gen() % 2 ? cheese : chicken)));
+        uint32_t change = gen() % 16;
+        if (change & 1)
+            order.without(Ingredient(gen() % INGREDIENT_COUNT));
+        if (change & 2)
+            order.extra(Ingredient(gen() % INGREDIENT_COUNT));
+        orders.push_back(order);
+    }
+
+    size_t steps = 0;
+    Stopwatch replanning;
+    for (auto& order : orders)
+        steps += planner.makePlan(order).recipe().amount[BUNS];
+    double replanSeconds = replanning.seconds();
+
+    Stopwatch memoized;
+    for (auto& order : orders)
+        steps += planner.plan(order).recipe().amount[BUNS];
+    double memoSeconds = memoized.seconds();
+
+    cout<<endl<<orders.size()<<" custom orders, "<<planner.cachedPlans()<<" unique plans"<<endl;
+    cout<<"Replanning every order: "<<replanSeconds * 1e9 / orders.size()<<" ns/order"<<endl;
+    cout<<"Memoized plans: "<<memoSeconds * 1e9 / orders.size()<<" ns/order ("
+        <<planner.cacheHits()<<" hits, "<<planner.cacheMisses()<<" misses)"<<endl;
+}
+
+#endif //LAB_1_CUSTOMORDER_H
@@ -6,13 +6,15 @@
 //Before
 
 class IEmployee{
+public:
     virtual void codeBackend() = 0;
     virtual void codeFrontend() = 0;
     virtual void deployApp() = 0;
     virtual void developNetwork() = 0;
+    virtual ~IEmployee() = default;
 };
 
-class Frontender:IEmployee
+class Frontender: public IEmployee
 {
 public:
     void codeBackend() override
@@ -49,26 +51,34 @@ void ISP_before()
 //After
 
 class IBackend{
+public:
     virtual void codeBackend() = 0;
+    virtual ~IBackend() = default;
 };
 
 
 class IFrontend{
+public:
     virtual void codeFrontend() = 0;
+    virtual ~IFrontend() = default;
 };
 
 
 class IDevOps{
+public:
     virtual void deployApp() = 0;
+    virtual ~IDevOps() = default;
 };
 
 
 class INetwork{
+public:
     virtual void developNetwork() = 0;
+    virtual ~INetwork() = default;
 };
 
 
-class FullStackDev: IBackend, IFrontend
+class FullStackDev: public IBackend, public IFrontend
 {
 public:
     void codeBackend() override
@@ -83,15 +93,15 @@ public:
 };
 
 
-class DevOpsEngineer : IDevOps{
+class DevOpsEngineer : public IDevOps{
 public:
-    void deployApp()
+    void deployApp() override
     {
         cout<<"Deploying App..."<<endl;
     }
 };
 
-class NetworkArchitect : INetwork{
+class NetworkArchitect : public INetwork{
 public:
     void developNetwork() override
     {
@@ -0,0 +1,204 @@
+#ifndef LAB_1_INVENTORY_H
+#define LAB_1_INVENTORY_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "KitchenExecutor.h"
+
+
+struct ReservationStats{
+    uint64_t reserved = 0;
+    uint64_t outOfStock = 0;
+    uint64_t rollbacks = 0;
+    uint64_t retries = 0;
+    uint64_t shortages[INGREDIENT_COUNT] = {};
+    uint64_t contention[INGREDIENT_COUNT] = {};
+};
+
+
+//Stock table the cooks draw from. There is no lock: every ingredient is its own atomic counter,
+//a recipe is reserved ingredient by ingredient with compare-and-swap, and the ingredients already
+//taken are handed back if a later one runs out.
+//While a rollback is in flight other cooks may briefly see the returned stock as missing.
+class IngredientStock{
+private:
+    //One cache line per ingredient, so cooks on different ingredients do not share one.
+    //C++14 new ignores the alignment: keep the stock on the stack or in static storage.
+    struct alignas(64) Slot{
+        atomic<int64_t> stock{0};
+        atomic<uint64_t> shortages{0};
+        atomic<uint64_t> contention{0};
+    };
+
+    Slot slots[INGREDIENT_COUNT];
+    atomic<uint64_t> reserved{0};
+    atomic<uint64_t> outOfStock{0};
+    atomic<uint64_t> rollbacks{0};
+
+    bool take(Ingredient ingredient, int64_t count)
+    {
+        Slot& slot = slots[ingredient];
+        int64_t current = slot.stock.load(memory_order_relaxed);
+        while (true)
+        {
+            if (current < count)
+            {
+                slot.shortages.fetch_add(1, memory_order_relaxed);
+                return false;
+            }
+            if (slot.stock.compare_exchange_weak(current, current - count, memory_order_acq_rel, memory_order_relaxed))
+                return true;
+            slot.contention.fetch_add(1, memory_order_relaxed);
+        }
+    }
+
+public:
+    void restock(Ingredient ingredient, int64_t count)
+    {
+        slots[ingredient].stock.fetch_add(count, memory_order_release);
+    }
+
+    int64_t available(Ingredient ingredient) const
+    {
+        return slots[ingredient].stock.load(memory_order_acquire);
+    }
+
+    //Takes every ingredient of the recipe or none of them
+    bool reserve(const Recipe& recipe)
+    {
+        bool tookAny = false;
+        for (int i = 0; i < INGREDIENT_COUNT; i++)
+        {
+            if (recipe.amount[i] == 0)
+                continue;
+            if (take(Ingredient(i), recipe.amount[i]))
+            {
+                tookAny = true;
+                continue;
+            }
+
+            if (tookAny)
+                rollbacks.fetch_add(1, memory_order_relaxed);
+            for (int j = 0; j < i; j++)
+                if (recipe.amount[j] > 0)
+                    restock(Ingredient(j), recipe.amount[j]);
+            outOfStock.fetch_add(1, memory_order_relaxed);
+            return false;
+        }
+        reserved.fetch_add(1, memory_order_relaxed);
+        return true;
+    }
+
+    void release(const Recipe& recipe)
+    {
+        for (int i = 0; i < INGREDIENT_COUNT; i++)
+            if (recipe.amount[i] > 0)
+                restock(Ingredient(i), recipe.amount[i]);
+    }
+
+    ReservationStats stats() const
+    {
+        ReservationStats s;
+        s.reserved = reserved.load();
+        s.outOfStock = outOfStock.load();
+        s.rollbacks = rollbacks.load();
+        for (int i = 0; i < INGREDIENT_COUNT; i++)
+        {
+            s.shortages[i] = slots[i].shortages.load();
+            s.contention[i] = slots[i].contention.load();
+            s.retries += s.contention[i];
+        }
+        return s;
+    }
+};
+
+
+//Decorator: only makes the burger if its ingredients could be reserved
+class StockedBurger : public IBurger
+{
+private:
+    IBurger* burger;
+    IngredientStock* stock;
+
+public:
+    StockedBurger(IBurger* b, IngredientStock* s)
+    {
+        burger = b;
+        stock = s;
+    }
+
+    void makeBurger() override
+    {
+        if (stock->reserve(burger->recipe()))
+            burger->makeBurger();
+        else
+            cout<<"Out of stock"<<endl;
+    }
+
+    void addBuns() override
+    {
+        burger->addBuns();
+    }
+
+    void addPatty() override
+    {
+        burger->addPatty();
+    }
+
+    void addToppings() override
+    {
+        burger->addToppings();
+    }
+
+    void addSauce() override
+    {
+        burger->addSauce();
+    }
+
+    Recipe recipe() const override
+    {
+        return burger->recipe();
+    }
+};
+
+
+void InventoryDemo()
+{
+    IngredientStock stock;
+    stock.restock(BUNS, 25000);
+    stock.restock(BEEF_PATTY, 15000);
+    stock.restock(CRISPY_CHICKEN_PATTY, 8000);
+    stock.restock(CHEESE, 10000);
+    stock.restock(LETTUCE, 8000);
+    stock.restock(TOMATO, 6000);
+    stock.restock(KETCHUP, 20000);
+    stock.restock(GARLIC_MAYO, 8000);
+
+    Hamburger hamburger;
+    Cheeseburger cheeseburger;
+    Crispychickenburger crispychickenburger;
+    StockedBurger stockedHamburger(&hamburger, &stock);
+    StockedBurger stockedCheeseburger(&cheeseburger, &stock);
+    StockedBurger stockedCrispychickenburger(&crispychickenburger, &stock);
+
+    vector<IBurger*> menu = {&stockedHamburger, &stockedCheeseburger, &stockedCrispychickenburger};
+    vector<IBurger*> orders;
+    for (size_t i = 0; i < 30000; i++)
+        orders.push_back(menu[i % menu.size()]);
+
+    {
+        MuteCout mute;
+        KitchenExecutor kitchen(4);
+        kitchen.submit(orders);
+    }
+
+    ReservationStats s = stock.stats();
+    cout<<"Reserved: "<<s.reserved<<", out of stock: "<<s.outOfStock
+        <<", rollbacks: "<<s.rollbacks<<", CAS retries: "<<s.retries<<endl;
+    for (int i = 0; i < INGREDIENT_COUNT; i++)
+        cout<<ingredientName(Ingredient(i))<<": "<<stock.available(Ingredient(i))<<" left, "
+            <<s.shortages[i]<<" shortages, "<<s.contention[i]<<" retries"<<endl;
+}
+
+#endif //LAB_1_INVENTORY_H
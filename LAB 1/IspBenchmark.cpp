@@ -0,0 +1,286 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <cstdint>
+#include <stdexcept>
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#include "ISP.h"
+#include "CapabilityScheduler.h"
+#include "RoleComposition.h"
+
+//Puts numbers on the ISP argument: the same team doing the same calls, once through the
+//fat IEmployee interface (ISP_before) and once through the role interfaces (ISP_after).
+//    ISP_BENCH [employees] [calls]
+
+
+//Hardware cache-miss counter for this thread; reports -1 where perf events are unavailable
+class CacheMissCounter{
+private:
+    int fd = -1;
+
+public:
+    CacheMissCounter()
+    {
+#ifdef __linux__
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    ~CacheMissCounter()
+    {
+#ifdef __linux__
+        if (fd >= 0)
+            close(fd);
+#endif
+    }
+
+    void start()
+    {
+#ifdef __linux__
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    long long stop()
+    {
+#ifdef __linux__
+        long long count = 0;
+        if (fd >= 0 && ioctl(fd, PERF_EVENT_IOC_DISABLE, 0) == 0 && read(fd, &count, sizeof(count)) == sizeof(count))
+            return count;
+#endif
+        return -1;
+    }
+};
+
+
+//Fat interface: every employee implements all four calls, most of them as "I don't know how"
+class FatFullStackDev : public IEmployee
+{
+public:
+    void codeBackend() override { SinkWork::log("Coding Backend..."); }
+    void codeFrontend() override { SinkWork::log("Coding Frontend..."); }
+    void deployApp() override { SinkWork::log("I don't know how to deploy an app"); }
+    void developNetwork() override { SinkWork::log("I don't know how to develop a Network Infrastructure"); }
+};
+
+class FatDevOpsEngineer : public IEmployee
+{
+public:
+    void codeBackend() override { SinkWork::log("I don't know how to code backend"); }
+    void codeFrontend() override { SinkWork::log("I don't know how to code frontend"); }
+    void deployApp() override { SinkWork::log("Deploying App..."); }
+    void developNetwork() override { SinkWork::log("I don't know how to develop a Network Infrastructure"); }
+};
+
+class FatNetworkArchitect : public IEmployee
+{
+public:
+    void codeBackend() override { SinkWork::log("I don't know how to code backend"); }
+    void codeFrontend() override { SinkWork::log("I don't know how to code frontend"); }
+    void deployApp() override { SinkWork::log("I don't know how to deploy an app"); }
+    void developNetwork() override { SinkWork::log("Developing network..."); }
+};
+
+//Role interfaces, same bodies (SinkFullStackDev comes from RoleComposition.h)
+class SinkDevOpsEngineer : public IDevOps
+{
+public:
+    void deployApp() override { SinkWork::log("Deploying App..."); }
+};
+
+class SinkNetworkArchitect : public INetwork
+{
+public:
+    void developNetwork() override { SinkWork::log("Developing network..."); }
+};
+
+
+//One role call: bits 0-1 the role, the rest the employee index
+typedef uint32_t Call;
+const size_t MAX_EMPLOYEES = size_t(1) << 30;
+
+struct Result{
+    double nsPerCall;
+    long long cacheMisses;
+};
+
+template <class Dispatch>
+Result run(const vector<Call>& calls, Dispatch dispatch)
+{
+    CacheMissCounter misses;
+    misses.start();
+    Stopwatch clock;
+    for (Call call : calls)
+        dispatch(Capability(call & 3), call >> 2);
+    double seconds = clock.seconds();
+    return Result{seconds * 1e9 / calls.size(), misses.stop()};
+}
+
+void print(const string& label, const Result& r, size_t objectBytes, size_t tableBytes)
+{
+    cout<<label<<r.nsPerCall<<" ns/call, ";
+    if (r.cacheMisses >= 0)
+        cout<<r.cacheMisses<<" cache misses, ";
+    else
+        cout<<"cache misses n/a, ";
+    cout<<objectBytes / 1024<<" KiB objects + "<<tableBytes / 1024<<" KiB pointers"<<endl;
+}
+
+//Whole-argument count: stoul accepts "12abc" and wraps "-1". Throws invalid_argument or out_of_range.
+size_t parseCount(const char* arg)
+{
+    string s = arg;
+    if (s.empty() || s[0] == '-')
+        throw invalid_argument(s);
+    size_t used = 0;
+    unsigned long long n = stoull(s, &used);
+    if (used != s.size() || n > SIZE_MAX)
+        throw invalid_argument(s);
+    return size_t(n);
+}
+
+int main(int argc, char** argv)
+{
+    size_t employees = 100000;
+    size_t callCount = 10000000;
+    try
+    {
+        if (argc > 1)
+            employees = parseCount(argv[1]);
+        if (argc > 2)
+            callCount = parseCount(argv[2]);
+    }
+    catch (const logic_error&)
+    {
+        employees = 0;
+    }
+    if (employees == 0 || employees > MAX_EMPLOYEES)
+    {
+        cout<<"Usage: ISP_BENCH [employees, 1 to "<<MAX_EMPLOYEES<<"] [calls]"<<endl;
+        return 1;
+    }
+    mt19937 gen(5);
+
+    //Employee i is a full-stack dev, devops engineer or network architect by i % 3.
+    //Both teams are allocated one object at a time in the same shuffled order, like a long-lived team.
+    vector<size_t> order(employees);
+    for (size_t i = 0; i < employees; i++)
+        order[i] = i;
+    shuffle(order.begin(), order.end(), gen);
+
+    //ISP_before: one fat pointer per employee
+    vector<unique_ptr<IEmployee>> fatTeam(employees);
+    size_t fatBytes = 0;
+    for (size_t i : order)
+    {
+        if (i % 3 == 0)
+            fatTeam[i].reset(new FatFullStackDev), fatBytes += sizeof(FatFullStackDev);
+        else if (i % 3 == 1)
+            fatTeam[i].reset(new FatDevOpsEngineer), fatBytes += sizeof(FatDevOpsEngineer);
+        else
+            fatTeam[i].reset(new FatNetworkArchitect), fatBytes += sizeof(FatNetworkArchitect);
+    }
+
+    //ISP_after: one table per role, null where the employee does not implement it
+    vector<IBackend*> backends(employees, nullptr);
+    vector<IFrontend*> frontends(employees, nullptr);
+    vector<IDevOps*> devOps(employees, nullptr);
+    vector<INetwork*> networks(employees, nullptr);
+    vector<unique_ptr<SinkFullStackDev>> fullStackDevs;
+    vector<unique_ptr<SinkDevOpsEngineer>> devOpsEngineers;
+    vector<unique_ptr<SinkNetworkArchitect>> networkArchitects;
+    size_t leanBytes = 0;
+    for (size_t i : order)
+    {
+        if (i % 3 == 0)
+        {
+            fullStackDevs.emplace_back(new SinkFullStackDev);
+            backends[i] = fullStackDevs.back().get();
+            frontends[i] = fullStackDevs.back().get();
+            leanBytes += sizeof(SinkFullStackDev);
+        }
+        else if (i % 3 == 1)
+        {
+            devOpsEngineers.emplace_back(new SinkDevOpsEngineer);
+            devOps[i] = devOpsEngineers.back().get();
+            leanBytes += sizeof(SinkDevOpsEngineer);
+        }
+        else
+        {
+            networkArchitects.emplace_back(new SinkNetworkArchitect);
+            networks[i] = networkArchitects.back().get();
+            leanBytes += sizeof(SinkNetworkArchitect);
+        }
+    }
+
+    //Random employee, then one of the roles that employee really has, so both designs do the same useful work
+    vector<Call> calls(callCount);
+    for (auto& call : calls)
+    {
+        uint32_t employee = uint32_t(gen() % employees);
+        Capability role = employee % 3 == 0 ? (gen() % 2 ? BACKEND : FRONTEND) : (employee % 3 == 1 ? DEVOPS : NETWORK);
+        call = employee << 2 | role;
+    }
+
+    auto fatCall = [&](Capability role, uint32_t e)
+    {
+        IEmployee* employee = fatTeam[e].get();
+        switch (role)
+        {
+            case BACKEND: employee->codeBackend(); break;
+            case FRONTEND: employee->codeFrontend(); break;
+            case DEVOPS: employee->deployApp(); break;
+            default: employee->developNetwork(); break;
+        }
+    };
+    auto leanCall = [&](Capability role, uint32_t e)
+    {
+        switch (role)
+        {
+            case BACKEND: backends[e]->codeBackend(); break;
+            case FRONTEND: frontends[e]->codeFrontend(); break;
+            case DEVOPS: devOps[e]->deployApp(); break;
+            default: networks[e]->developNetwork(); break;
+        }
+    };
+
+    //Warm both teams up once, then measure
+    run(calls, fatCall);
+    run(calls, leanCall);
+    roleWorkCount = 0;
+    Result fat = run(calls, fatCall);
+    Result lean = run(calls, leanCall);
+
+    cout<<employees<<" employees, "<<callCount<<" role calls per design ("<<roleWorkCount<<" counted across both)"<<endl;
+    cout<<"Object sizes: fat "<<sizeof(FatFullStackDev)<<"/"<<sizeof(FatDevOpsEngineer)<<"/"<<sizeof(FatNetworkArchitect)
+        <<" B, role interfaces "<<sizeof(SinkFullStackDev)<<"/"<<sizeof(SinkDevOpsEngineer)<<"/"<<sizeof(SinkNetworkArchitect)
+        <<" B (full-stack/devops/network)"<<endl;
+    cout<<"Role-call vtable slots: fat 12, 8 of them \"I don't know how\" stubs; role interfaces 4, none"<<endl;
+    print("IEmployee (ISP_before):      ", fat, fatBytes, fatTeam.size() * sizeof(IEmployee*));
+    print("Role interfaces (ISP_after): ", lean, leanBytes, employees * (sizeof(IBackend*) + sizeof(IFrontend*) + sizeof(IDevOps*) + sizeof(INetwork*)));
+    return 0;
+}
@@ -0,0 +1,263 @@
+#ifndef LAB_1_KITCHENEXECUTOR_H
+#define LAB_1_KITCHENEXECUTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "Bench.h"
+
+
+struct KitchenStats{
+    uint64_t orders = 0;
+    uint64_t stolen = 0;
+    double seconds = 0;
+    double ordersPerSecond = 0;
+    size_t maxQueueDepth = 0;
+    double avgQueueDepth = 0;
+    vector<uint64_t> perCook;
+};
+
+
+//Runs IBurger::makeBurger on a pool of cooks.
+//Every cook owns a deque: it takes its own orders from the back and,
+//when it runs dry, steals the oldest order from the front of another cook's deque.
+//New orders are dealt round-robin, so a burst of one burger type is spread over all cooks.
+class KitchenExecutor{
+private:
+    struct Cook{
+        mutex lock;
+        deque<IBurger*> orders;
+        atomic<uint64_t> made{0};
+    };
+
+    vector<unique_ptr<Cook>> cooks;
+    vector<thread> threads;
+
+    atomic<bool> stopping{false};
+    atomic<size_t> queued{0};
+    atomic<size_t> pending{0};
+    atomic<int> sleeping{0};
+    atomic<size_t> nextCook{0};
+
+    mutex wakeLock;
+    condition_variable wakeUp;
+    mutex doneLock;
+    condition_variable allDone;
+
+    atomic<uint64_t> stolen{0};
+    atomic<size_t> maxDepth{0};
+    atomic<uint64_t> depthSamples{0};
+    atomic<uint64_t> depthSum{0};
+    Stopwatch clock;
+
+    bool popOwn(size_t id, IBurger*& order)
+    {
+        Cook& cook = *cooks[id];
+        lock_guard<mutex> guard(cook.lock);
+        if (cook.orders.empty())
+            return false;
+        order = cook.orders.back();
+        cook.orders.pop_back();
+        return true;
+    }
+
+    bool steal(size_t thief, IBurger*& order)
+    {
+        for (size_t i = 1; i < cooks.size(); i++)
+        {
+            Cook& victim = *cooks[(thief + i) % cooks.size()];
+            lock_guard<mutex> guard(victim.lock);
+            if (victim.orders.empty())
+                continue;
+            order = victim.orders.front();
+            victim.orders.pop_front();
+            stolen.fetch_add(1, memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    void finishOrder(size_t id)
+    {
+        cooks[id]->made.fetch_add(1, memory_order_relaxed);
+        if (pending.fetch_sub(1) == 1)
+        {
+            lock_guard<mutex> guard(doneLock);
+            allDone.notify_all();
+        }
+    }
+
+    void work(size_t id)
+    {
+        while (true)
+        {
+            IBurger* order = nullptr;
+            if (popOwn(id, order) || steal(id, order))
+            {
+                queued.fetch_sub(1);
+                order->makeBurger();
+                finishOrder(id);
+                continue;
+            }
+
+            unique_lock<mutex> guard(wakeLock);
+            sleeping.fetch_add(1);
+            wakeUp.wait(guard, [this]{ return stopping.load() || queued.load() > 0; });
+            sleeping.fetch_sub(1);
+            if (stopping.load() && queued.load() == 0)
+                return;
+        }
+    }
+
+    void recordDepth(size_t depth)
+    {
+        depthSamples.fetch_add(1, memory_order_relaxed);
+        depthSum.fetch_add(depth, memory_order_relaxed);
+        size_t seen = maxDepth.load(memory_order_relaxed);
+        while (depth > seen && !maxDepth.compare_exchange_weak(seen, depth, memory_order_relaxed));
+    }
+
+public:
+    explicit KitchenExecutor(size_t cookCount)
+    {
+        if (cookCount == 0)
+            cookCount = 1;
+        for (size_t i = 0; i < cookCount; i++)
+            cooks.emplace_back(new Cook);
+        for (size_t i = 0; i < cookCount; i++)
+            threads.emplace_back(&KitchenExecutor::work, this, i);
+    }
+
+    KitchenExecutor(const KitchenExecutor&) = delete;
+
+    ~KitchenExecutor()
+    {
+        waitIdle();
+        {
+            lock_guard<mutex> guard(wakeLock);
+            stopping = true;
+        }
+        wakeUp.notify_all();
+        for (auto& t : threads)
+            t.join();
+    }
+
+    void submit(IBurger* burger)
+    {
+        size_t id = nextCook.fetch_add(1, memory_order_relaxed) % cooks.size();
+        Cook& cook = *cooks[id];
+        size_t depth;
+        pending.fetch_add(1);
+        queued.fetch_add(1);
+        {
+            lock_guard<mutex> guard(cook.lock);
+            cook.orders.push_back(burger);
+            depth = cook.orders.size();
+        }
+        recordDepth(depth);
+
+        if (sleeping.load() > 0)
+        {
+            { lock_guard<mutex> guard(wakeLock); }
+            wakeUp.notify_one();
+        }
+    }
+
+    void submit(const vector<IBurger*>& orders)
+    {
+        for (auto burger : orders)
+            submit(burger);
+    }
+
+    void waitIdle()
+    {
+        unique_lock<mutex> guard(doneLock);
+        allDone.wait(guard, [this]{ return pending.load() == 0; });
+    }
+
+    //Clears the counters and restarts the throughput clock. Call it while the kitchen is idle.
+    void resetStats()
+    {
+        for (auto& cook : cooks)
+            cook->made = 0;
+        stolen = 0;
+        maxDepth = 0;
+        depthSamples = 0;
+        depthSum = 0;
+        clock.reset();
+    }
+
+    KitchenStats stats() const
+    {
+        KitchenStats s;
+        for (auto& cook : cooks)
+        {
+            s.perCook.push_back(cook->made.load());
+            s.orders += s.perCook.back();
+        }
+        s.stolen = stolen.load();
+        s.seconds = clock.seconds();
+        s.ordersPerSecond = s.seconds > 0 ? s.orders / s.seconds : 0;
+        s.maxQueueDepth = maxDepth.load();
+        uint64_t samples = depthSamples.load();
+        s.avgQueueDepth = samples ? double(depthSum.load()) / samples : 0;
+        return s;
+    }
+
+    size_t cookCount() const
+    {
+        return cooks.size();
+    }
+};
+
+
+void printKitchenStats(const KitchenStats& s)
+{
+    cout<<"Orders: "<<s.orders<<" in "<<s.seconds<<" s ("<<(uint64_t)s.ordersPerSecond<<" orders/s)"<<endl;
+    cout<<"Queue depth: avg "<<s.avgQueueDepth<<", max "<<s.maxQueueDepth<<endl;
+    cout<<"Stolen orders: "<<s.stolen<<endl;
+    for (size_t i = 0; i < s.perCook.size(); i++)
+        cout<<"Cook "<<i<<" made "<<s.perCook[i]<<endl;
+}
+
+
+void KitchenExecutorDemo()
+{
+    Hamburger hamburger;
+    Cheeseburger cheeseburger;
+    Crispychickenburger crispychickenburger;
+
+    //Lunch rush: a burst of cheeseburgers followed by a mixed stream
+    vector<IBurger*> orders(100000, &cheeseburger);
+    vector<IBurger*> menu = {&hamburger, &cheeseburger, &crispychickenburger};
+    for (size_t i = 0; i < 100000; i++)
+        orders.push_back(menu[i % menu.size()]);
+
+    double singleSeconds;
+    KitchenStats stats;
+    {
+        MuteCout mute;
+
+        Stopwatch single;
+        for (auto burger : orders)
+            burger->makeBurger();
+        singleSeconds = single.seconds();
+
+        KitchenExecutor kitchen(4);
+        kitchen.resetStats();
+        kitchen.submit(orders);
+        kitchen.waitIdle();
+        stats = kitchen.stats();
+    }
+
+    cout<<"Single cook: "<<(uint64_t)(orders.size() / singleSeconds)<<" orders/s"<<endl;
+    cout<<"Work-stealing kitchen, "<<stats.perCook.size()<<" cooks:"<<endl;
+    printKitchenStats(stats);
+}
+
+#endif //LAB_1_KITCHENEXECUTOR_H
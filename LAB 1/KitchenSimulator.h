@@ -0,0 +1,332 @@
+#ifndef LAB_1_KITCHENSIMULATOR_H
+#define LAB_1_KITCHENSIMULATOR_H
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <stdexcept>
+
+#include "Bench.h"
+#include "LatencyHistogram.h"
+
+
+struct KitchenConfig{
+    //Orders a station can work on at once: cooks at the station, or patties that fit on the grill
+    unsigned capacity[STATION_COUNT] = {2, 12, 2, 1};
+    double secondsPer[INGREDIENT_COUNT] = {20, 180, 240, 10, 8, 8, 5, 5};
+    //Arrival rate for every hour the kitchen is open
+    vector<double> ordersPerHour = {40, 60, 220, 260, 90, 50, 60, 120, 180, 140, 70, 40};
+    uint64_t seed = 7;
+};
+
+struct StationReport{
+    double utilization = 0;
+    uint64_t served = 0;
+    double avgWait = 0;
+    double maxWait = 0;
+    double p95Wait = 0;
+};
+
+struct SimulationReport{
+    uint64_t orders = 0;
+    double simulatedSeconds = 0;
+    double wallSeconds = 0;
+    double avgOrderTime = 0;
+    double p95OrderTime = 0;
+    StationReport stations[STATION_COUNT];
+};
+
+
+//Binary min-heap is the usual choice; a 4-ary heap halves the depth and keeps the four
+//children of a node next to each other (64 bytes of events, at most two cache lines), which
+//matters once millions of events go through it.
+class EventQueue{
+public:
+    struct Event{
+        double time;
+        uint32_t order;
+        int32_t station;    //-1 = arrival
+    };
+
+private:
+    vector<Event> heap;
+
+public:
+    bool empty() const
+    {
+        return heap.empty();
+    }
+
+    void push(Event e)
+    {
+        size_t i = heap.size();
+        heap.push_back(e);
+        while (i > 0)
+        {
+            size_t parent = (i - 1) / 4;
+            if (heap[parent].time <= e.time)
+                break;
+            heap[i] = heap[parent];
+            i = parent;
+        }
+        heap[i] = e;
+    }
+
+    Event pop()
+    {
+        Event top = heap[0];
+        Event last = heap.back();
+        heap.pop_back();
+        size_t n = heap.size();
+        size_t i = 0;
+        while (true)
+        {
+            size_t first = 4 * i + 1;
+            if (first >= n)
+                break;
+            size_t best = first;
+            size_t end = first + 4 < n ? first + 4 : n;
+            for (size_t c = first + 1; c < end; c++)
+                if (heap[c].time < heap[best].time)
+                    best = c;
+            if (last.time <= heap[best].time)
+                break;
+            heap[i] = heap[best];
+            i = best;
+        }
+        if (n > 0)
+            heap[i] = last;
+        return top;
+    }
+};
+
+
+//Discrete-event model of a day in the kitchen. Every order walks the stations its recipe needs,
+//in order; a station serves as many orders at once as it has cooks (or grills), the rest queue FIFO.
+//Step times come from the ingredients of the menu burgers.
+class KitchenSimulator{
+private:
+    struct Order{
+        double arrived;
+        double queuedAt;
+        uint32_t item;
+    };
+
+    struct StationState{
+        unsigned busy = 0;
+        deque<uint32_t> waiting;
+        double busyTime = 0;
+        double waitSum = 0;
+        double maxWait = 0;
+        uint64_t served = 0;
+        LatencyHistogram waitMillis;
+    };
+
+    KitchenConfig config;
+    vector<array<double, STATION_COUNT>> stepTime;
+
+    EventQueue events;
+    vector<Order> orders;
+    vector<uint32_t> freeOrders;
+    StationState stations[STATION_COUNT];
+    LatencyHistogram orderMillis;
+    double orderTimeSum = 0;
+    uint64_t completed = 0;
+
+    uint32_t newOrder(double now, uint32_t item)
+    {
+        uint32_t id;
+        if (freeOrders.empty())
+        {
+            id = uint32_t(orders.size());
+            orders.push_back(Order());
+        }
+        else
+        {
+            id = freeOrders.back();
+            freeOrders.pop_back();
+        }
+        orders[id] = Order{now, now, item};
+        return id;
+    }
+
+    void start(uint32_t id, int station, double now)
+    {
+        StationState& s = stations[station];
+        double wait = now - orders[id].queuedAt;
+        double duration = stepTime[orders[id].item][station];
+        s.busy++;
+        s.busyTime += duration;
+        s.waitSum += wait;
+        s.maxWait = wait > s.maxWait ? wait : s.maxWait;
+        s.served++;
+        s.waitMillis.record(uint64_t(wait * 1000));
+        events.push(EventQueue::Event{now + duration, id, station});
+    }
+
+    //Sends the order to the first station at or after 'from' that its recipe uses
+    void advance(uint32_t id, int from, double now)
+    {
+        int station = from;
+        while (station < STATION_COUNT && stepTime[orders[id].item][station] <= 0)
+            station++;
+
+        if (station == STATION_COUNT)
+        {
+            double total = now - orders[id].arrived;
+            orderTimeSum += total;
+            orderMillis.record(uint64_t(total * 1000));
+            completed++;
+            freeOrders.push_back(id);
+            return;
+        }
+
+        orders[id].queuedAt = now;
+        if (stations[station].busy < config.capacity[station])
+            start(id, station, now);
+        else
+            stations[station].waiting.push_back(id);
+    }
+
+    void finish(uint32_t id, int station, double now)
+    {
+        StationState& s = stations[station];
+        s.busy--;
+        if (!s.waiting.empty())
+        {
+            uint32_t next = s.waiting.front();
+            s.waiting.pop_front();
+            start(next, station, now);
+        }
+        advance(id, station + 1, now);
+    }
+
+public:
+    //Throws invalid_argument if a station the menu needs has no capacity, since its orders
+    //would never finish
+    KitchenSimulator(const KitchenConfig& c, const vector<IBurger*>& menu)
+    {
+        config = c;
+        for (auto burger : menu)
+        {
+            Recipe recipe = burger->recipe();
+            array<double, STATION_COUNT> times = {};
+            for (int i = 0; i < INGREDIENT_COUNT; i++)
+                times[stationOf(Ingredient(i))] += recipe.amount[i] * config.secondsPer[i];
+            for (int station = 0; station < STATION_COUNT; station++)
+                if (times[station] > 0 && config.capacity[station] == 0)
+                    throw invalid_argument(string("KitchenSimulator: ") + stationName(Station(station))
+                                           + " has no capacity");
+            stepTime.push_back(times);
+        }
+    }
+
+    SimulationReport run()
+    {
+        Stopwatch wall;
+        mt19937_64 gen(config.seed);
+        uniform_int_distribution<uint32_t> pickItem(0, uint32_t(stepTime.size() - 1));
+        double close = config.ordersPerHour.size() * 3600.0;
+
+        //Arrivals are generated one at a time, so only one is ever waiting in the queue
+        auto nextArrival = [&](double now) {
+            while (true)
+            {
+                size_t hour = size_t(now / 3600);
+                if (hour >= config.ordersPerHour.size())
+                    return;
+                double rate = config.ordersPerHour[hour] / 3600.0;
+                if (rate <= 0)
+                {
+                    now = (hour + 1) * 3600.0;
+                    continue;
+                }
+                double at = now + exponential_distribution<double>(rate)(gen);
+                if (at < (hour + 1) * 3600.0)
+                {
+                    events.push(EventQueue::Event{at, 0, -1});
+                    return;
+                }
+                now = (hour + 1) * 3600.0;
+            }
+        };
+
+        double now = 0;
+        if (!stepTime.empty())
+            nextArrival(0);
+        while (!events.empty())
+        {
+            EventQueue::Event e = events.pop();
+            now = e.time;
+            if (e.station < 0)
+            {
+                advance(newOrder(now, pickItem(gen)), 0, now);
+                nextArrival(now);
+            }
+            else
+                finish(e.order, e.station, now);
+        }
+
+        SimulationReport report;
+        report.orders = completed;
+        report.simulatedSeconds = now > close ? now : close;
+        report.wallSeconds = wall.seconds();
+        report.avgOrderTime = completed ? orderTimeSum / completed : 0;
+        report.p95OrderTime = orderMillis.percentile(95) / 1000.0;
+        for (int i = 0; i < STATION_COUNT; i++)
+        {
+            StationState& s = stations[i];
+            StationReport& r = report.stations[i];
+            r.served = s.served;
+            r.utilization = config.capacity[i] ? s.busyTime / (config.capacity[i] * report.simulatedSeconds) : 0;
+            r.avgWait = s.served ? s.waitSum / s.served : 0;
+            r.maxWait = s.maxWait;
+            r.p95Wait = s.waitMillis.percentile(95) / 1000.0;
+        }
+        return report;
+    }
+};
+
+
+void printSimulationReport(const SimulationReport& r, const KitchenConfig& config)
+{
+    cout<<r.orders<<" orders over "<<r.simulatedSeconds / 3600<<" h, order time avg "<<r.avgOrderTime
+        <<" s, p95 "<<r.p95OrderTime<<" s"<<endl;
+    for (int i = 0; i < STATION_COUNT; i++)
+    {
+        const StationReport& s = r.stations[i];
+        cout<<"  "<<stationName(Station(i))<<" x"<<config.capacity[i]<<": utilization "<<s.utilization * 100
+            <<"%, wait avg "<<s.avgWait<<" s, p95 "<<s.p95Wait<<" s, max "<<s.maxWait<<" s"<<endl;
+    }
+}
+
+
+void KitchenSimulatorDemo()
+{
+    Hamburger hamburger;
+    Cheeseburger cheeseburger;
+    Crispychickenburger crispychickenburger;
+    vector<IBurger*> menu = {&hamburger, &cheeseburger, &crispychickenburger};
+
+    for (unsigned grills : {12u, 16u})
+    {
+        KitchenConfig config;
+        config.capacity[GRILL] = grills;
+        KitchenSimulator simulator(config, menu);
+        cout<<"One day with "<<grills<<" grill slots:"<<endl;
+        printSimulationReport(simulator.run(), config);
+    }
+
+    //Simulator speed: a very busy hour with a kitchen big enough to keep up
+    KitchenConfig busy;
+    busy.ordersPerHour = {500000};
+    for (auto& c : busy.capacity)
+        c = 50000;
+    KitchenSimulator simulator(busy, menu);
+    SimulationReport r = simulator.run();
+    cout<<"Simulated "<<r.orders<<" orders in "<<r.wallSeconds<<" s ("
+        <<(uint64_t)(r.orders / r.wallSeconds)<<" orders/s)"<<endl;
+}
+
+#endif //LAB_1_KITCHENSIMULATOR_H
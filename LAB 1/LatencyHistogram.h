@@ -0,0 +1,290 @@
+#ifndef LAB_1_LATENCYHISTOGRAM_H
+#define LAB_1_LATENCYHISTOGRAM_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <typeinfo>
+#ifdef __GNUG__
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+
+#include "Bench.h"
+
+
+//HDR-style histogram of nanosecond latencies: 32 linear sub-buckets per power of two,
+//so every recorded value is kept to within about 3%.
+//Only one thread records into a histogram; any thread may read or merge it. Recording is a plain
+//load and store, so reset() is only for a quiescent histogram: a sample recorded during a reset
+//may be lost or brought back.
+class LatencyHistogram{
+public:
+    static const int SUB_BITS = 5;
+    static const int SUB_COUNT = 1 << SUB_BITS;
+    static const int BUCKET_COUNT = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+private:
+    atomic<uint64_t> counts[BUCKET_COUNT];
+    atomic<uint64_t> total{0};
+    atomic<uint64_t> maxValue{0};
+
+    static void bump(atomic<uint64_t>& counter, uint64_t by)
+    {
+        counter.store(counter.load(memory_order_relaxed) + by, memory_order_relaxed);
+    }
+
+public:
+    LatencyHistogram()
+    {
+        reset();
+    }
+
+    static int bucketOf(uint64_t value)
+    {
+        if (value < SUB_COUNT)
+            return int(value);
+        int exponent = 63 - __builtin_clzll(value);
+        int shift = exponent - SUB_BITS;
+        return (shift + 1) * SUB_COUNT + int((value >> shift) - SUB_COUNT);
+    }
+
+    //Middle of the value range a bucket covers
+    static uint64_t valueOf(int bucket)
+    {
+        if (bucket < SUB_COUNT)
+            return uint64_t(bucket);
+        int shift = bucket / SUB_COUNT - 1;
+        uint64_t low = uint64_t(SUB_COUNT + bucket % SUB_COUNT) << shift;
+        return low + ((uint64_t(1) << shift) >> 1);
+    }
+
+    void record(uint64_t nanoseconds)
+    {
+        bump(counts[bucketOf(nanoseconds)], 1);
+        bump(total, 1);
+        if (nanoseconds > maxValue.load(memory_order_relaxed))
+            maxValue.store(nanoseconds, memory_order_relaxed);
+    }
+
+    void merge(const LatencyHistogram& other)
+    {
+        for (int i = 0; i < BUCKET_COUNT; i++)
+        {
+            uint64_t c = other.counts[i].load(memory_order_relaxed);
+            if (c)
+                counts[i].fetch_add(c, memory_order_relaxed);
+        }
+        total.fetch_add(other.total.load(memory_order_relaxed), memory_order_relaxed);
+        uint64_t otherMax = other.maxValue.load(memory_order_relaxed);
+        uint64_t seen = maxValue.load(memory_order_relaxed);
+        while (otherMax > seen && !maxValue.compare_exchange_weak(seen, otherMax, memory_order_relaxed));
+    }
+
+    //Not while another thread records into this histogram
+    void reset()
+    {
+        for (auto& c : counts)
+            c.store(0, memory_order_relaxed);
+        total = 0;
+        maxValue = 0;
+    }
+
+    uint64_t count() const
+    {
+        return total.load(memory_order_relaxed);
+    }
+
+    uint64_t max() const
+    {
+        return maxValue.load(memory_order_relaxed);
+    }
+
+    uint64_t percentile(double p) const
+    {
+        uint64_t n = count();
+        if (n == 0)
+            return 0;
+        uint64_t rank = uint64_t(p / 100.0 * n + 0.5);
+        if (rank < 1)
+            rank = 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKET_COUNT; i++)
+        {
+            seen += counts[i].load(memory_order_relaxed);
+            if (seen >= rank)
+                return valueOf(i) < max() ? valueOf(i) : max();
+        }
+        return max();
+    }
+};
+
+
+string readableTypeName(const type_info& type)
+{
+#ifdef __GNUG__
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+    if (status == 0 && demangled)
+    {
+        string name = demangled;
+        free(demangled);
+        return name;
+    }
+#endif
+    return type.name();
+}
+
+
+//One histogram per (thread, concrete burger type). A thread finds its histograms in a small
+//thread-local cache, so recording takes no lock; only the first order of a new type on a
+//thread registers a histogram under the mutex.
+//When a thread exits its histograms are folded into one retired histogram per type and freed,
+//so memory follows the threads alive, not every thread that ever recorded.
+class LatencyRecorder{
+private:
+    struct Entry{
+        const type_info* type;
+        unique_ptr<LatencyHistogram> histogram;
+        bool retired;
+    };
+
+    //A thread's histograms, handed back when the thread exits
+    struct ThreadHistograms{
+        vector<pair<const type_info*, LatencyHistogram*>> cache;
+
+        ~ThreadHistograms()
+        {
+            for (auto& cached : cache)
+                LatencyRecorder::instance().retire(cached.second);
+        }
+    };
+
+    mutex lock;
+    vector<Entry> entries;
+
+    LatencyRecorder() = default;
+
+    LatencyHistogram* registerHistogram(const type_info& type)
+    {
+        lock_guard<mutex> guard(lock);
+        entries.push_back(Entry{&type, unique_ptr<LatencyHistogram>(new LatencyHistogram), false});
+        return entries.back().histogram.get();
+    }
+
+    void retire(LatencyHistogram* histogram)
+    {
+        lock_guard<mutex> guard(lock);
+        size_t live = entries.size();
+        for (size_t i = 0; i < entries.size(); i++)
+            if (entries[i].histogram.get() == histogram)
+                live = i;
+        if (live == entries.size())
+            return;
+
+        const type_info& type = *entries[live].type;
+        LatencyHistogram* retired = nullptr;
+        for (auto& entry : entries)
+            if (entry.retired && (entry.type == &type || *entry.type == type))
+                retired = entry.histogram.get();
+        if (retired == nullptr)
+            entries.push_back(Entry{&type, unique_ptr<LatencyHistogram>(new LatencyHistogram), true});
+        (retired ? *retired : *entries.back().histogram).merge(*histogram);
+        swap(entries[live], entries.back());
+        entries.pop_back();
+    }
+
+public:
+    LatencyRecorder(const LatencyRecorder&) = delete;
+
+    static LatencyRecorder& instance()
+    {
+        static LatencyRecorder recorder;
+        return recorder;
+    }
+
+    LatencyHistogram& histogramFor(const type_info& type)
+    {
+        thread_local ThreadHistograms mine;
+        for (auto& cached : mine.cache)
+            if (cached.first == &type || *cached.first == type)
+                return *cached.second;
+        mine.cache.emplace_back(&type, registerHistogram(type));
+        return *mine.cache.back().second;
+    }
+
+    void record(const type_info& type, uint64_t nanoseconds)
+    {
+        histogramFor(type).record(nanoseconds);
+    }
+
+    //Merges the per-thread histograms of every type
+    map<string, unique_ptr<LatencyHistogram>> snapshot()
+    {
+        map<string, unique_ptr<LatencyHistogram>> merged;
+        lock_guard<mutex> guard(lock);
+        for (auto& entry : entries)
+        {
+            auto& histogram = merged[readableTypeName(*entry.type)];
+            if (!histogram)
+                histogram.reset(new LatencyHistogram);
+            histogram->merge(*entry.histogram);
+        }
+        return merged;
+    }
+
+    //Only while no thread is recording
+    void reset()
+    {
+        lock_guard<mutex> guard(lock);
+        for (auto& entry : entries)
+            entry.histogram->reset();
+    }
+
+    void printPercentiles()
+    {
+        for (auto& item : snapshot())
+        {
+            const LatencyHistogram& h = *item.second;
+            cout<<item.first<<": "<<h.count()<<" orders, p50 "<<h.percentile(50)<<" ns, p90 "<<h.percentile(90)
+                <<" ns, p99 "<<h.percentile(99)<<" ns, p99.9 "<<h.percentile(99.9)<<" ns, max "<<h.max()<<" ns"<<endl;
+        }
+    }
+};
+
+
+void makeBurgerTimed(IBurger& burger)
+{
+    auto start = chrono::steady_clock::now();
+    burger.makeBurger();
+    auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start);
+    LatencyRecorder::instance().record(typeid(burger), uint64_t(elapsed.count()));
+}
+
+
+void LatencyHistogramDemo()
+{
+    Hamburger hamburger;
+    Cheeseburger cheeseburger;
+    Crispychickenburger crispychickenburger;
+    vector<IBurger*> menu = {&hamburger, &cheeseburger, &crispychickenburger};
+
+    LatencyRecorder::instance().reset();
+    {
+        MuteCout mute;
+        vector<thread> cooks;
+        for (size_t c = 0; c < 4; c++)
+            cooks.emplace_back([&menu, c]{
+                for (size_t i = 0; i < 50000; i++)
+                    makeBurgerTimed(*menu[(i + c) % menu.size()]);
+            });
+        for (auto& t : cooks)
+            t.join();
+    }
+    LatencyRecorder::instance().printPercentiles();
+}
+
+#endif //LAB_1_LATENCYHISTOGRAM_H
@@ -2,6 +2,8 @@
 #ifndef LAB_1_OCP_H
 #define LAB_1_OCP_H
 
+#include <cstdint>
+
 
 //Before
 
@@ -70,9 +72,80 @@ void OCP_before(){
 
 //After
 
+enum Ingredient{
+    BUNS,
+    BEEF_PATTY,
+    CRISPY_CHICKEN_PATTY,
+    CHEESE,
+    LETTUCE,
+    TOMATO,
+    KETCHUP,
+    GARLIC_MAYO,
+    INGREDIENT_COUNT
+};
+
+const char* ingredientName(Ingredient ingredient)
+{
+    static const char* names[INGREDIENT_COUNT] = {
+            "buns", "beef patty", "crispy chicken patty", "cheese",
+            "lettuce", "tomato", "ketchup", "garlic mayo"
+    };
+    return names[ingredient];
+}
+
+enum Station{
+    BUN_STATION,
+    GRILL,
+    TOPPING_STATION,
+    SAUCE_STATION,
+    STATION_COUNT
+};
+
+const char* stationName(Station station)
+{
+    static const char* names[STATION_COUNT] = {"Bun station", "Grill", "Topping station", "Sauce station"};
+    return names[station];
+}
+
+Station stationOf(Ingredient ingredient)
+{
+    switch (ingredient)
+    {
+        case BUNS:
+            return BUN_STATION;
+        case BEEF_PATTY:
+        case CRISPY_CHICKEN_PATTY:
+            return GRILL;
+        case CHEESE:
+        case LETTUCE:
+        case TOMATO:
+            return TOPPING_STATION;
+        default:
+            return SAUCE_STATION;
+    }
+}
+
+//How much of every ingredient one burger uses
+struct Recipe{
+    uint8_t amount[INGREDIENT_COUNT] = {};
+
+    Recipe& add(Ingredient ingredient, uint8_t count = 1)
+    {
+        amount[ingredient] += count;
+        return *this;
+    }
+};
+
+//Every recipe goes through the same stations: buns, patty, toppings, sauce
 class IBurger{
 public:
     virtual void makeBurger() = 0;
+    virtual void addBuns() = 0;
+    virtual void addPatty() = 0;
+    virtual void addToppings() = 0;
+    virtual void addSauce() = 0;
+    virtual Recipe recipe() const = 0;
+    virtual ~IBurger() = default;
 };
 
 class Hamburger: public IBurger
@@ -81,10 +154,35 @@ public:
     void makeBurger() override
     {
         cout<<"Making Hamburger"<<endl;
+        addBuns();
+        addPatty();
+        addToppings();
+        addSauce();
+    }
+
+    void addBuns() override
+    {
         cout<<"Adding buns"<<endl;
+    }
+
+    void addPatty() override
+    {
         cout<<"Adding beef patty"<<endl;
+    }
+
+    void addToppings() override
+    {
+    }
+
+    void addSauce() override
+    {
         cout<<"Adding ketchup"<<endl;
     }
+
+    Recipe recipe() const override
+    {
+        return Recipe().add(BUNS).add(BEEF_PATTY).add(KETCHUP);
+    }
 };
 
 class Cheeseburger: public IBurger
@@ -93,12 +191,37 @@ public:
     void makeBurger() override
     {
         cout<<"Making Cheeseburger"<<endl;
+        addBuns();
+        addPatty();
+        addToppings();
+        addSauce();
+    }
+
+    void addBuns() override
+    {
         cout<<"Adding buns"<<endl;
+    }
+
+    void addPatty() override
+    {
         cout<<"Adding beef patty"<<endl;
+    }
+
+    void addToppings() override
+    {
         cout<<"Adding cheese"<<endl;
+    }
+
+    void addSauce() override
+    {
         cout<<"Adding ketchup"<<endl;
     }
 
+    Recipe recipe() const override
+    {
+        return Recipe().add(BUNS).add(BEEF_PATTY).add(CHEESE).add(KETCHUP);
+    }
+
 };
 
 
@@ -108,12 +231,37 @@ public:
     void makeBurger() override
     {
         cout<<"Making CrispyChickenBurger"<<endl;
+        addBuns();
+        addPatty();
+        addToppings();
+        addSauce();
+    }
+
+    void addBuns() override
+    {
         cout<<"Adding buns"<<endl;
+    }
+
+    void addPatty() override
+    {
         cout<<"Adding crispy chicken patty"<<endl;
+    }
+
+    void addToppings() override
+    {
         cout<<"Adding lettuce"<<endl;
         cout<<"Adding tomato"<<endl;
+    }
+
+    void addSauce() override
+    {
         cout<<"Adding garlic mayo"<<endl;
     }
+
+    Recipe recipe() const override
+    {
+        return Recipe().add(BUNS).add(CRISPY_CHICKEN_PATTY).add(LETTUCE).add(TOMATO).add(GARLIC_MAYO);
+    }
 };
 
 
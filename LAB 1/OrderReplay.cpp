@@ -0,0 +1,147 @@
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "OCP.h"
+#include "OrderReplay.h"
+
+//Replays a recorded order trace against the burger classes.
+//    ORDER_REPLAY <trace> [--recorded] [--speed X] [--cooks N] [--menu menu.txt] [--verbose]
+//    ORDER_REPLAY --generate <trace> <orders> <seconds>
+//A trace ending in .csv is written as CSV, anything else as binary.
+
+void usage()
+{
+    cout<<"Usage: ORDER_REPLAY <trace> [--recorded] [--speed X] [--cooks N] [--menu menu.txt] [--verbose]"<<endl;
+    cout<<"       ORDER_REPLAY --generate <trace> <orders> <seconds>"<<endl;
+}
+
+bool endsWith(const string& s, const string& suffix)
+{
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+//Whole-argument parsing: stoul and stod accept "12abc" and wrap "-1", so check both.
+//Throws invalid_argument or out_of_range.
+size_t parseCount(const string& arg)
+{
+    if (arg.empty() || arg[0] == '-')
+        throw invalid_argument(arg);
+    size_t used = 0;
+    unsigned long long n = stoull(arg, &used);
+    if (used != arg.size() || n > SIZE_MAX)
+        throw invalid_argument(arg);
+    return size_t(n);
+}
+
+double parsePositive(const string& arg)
+{
+    size_t used = 0;
+    double x = stod(arg, &used);
+    if (used != arg.size() || !(x > 0) || !isfinite(x))
+        throw invalid_argument(arg);
+    return x;
+}
+
+int main(int argc, char** argv)
+{
+    vector<string> args(argv + 1, argv + argc);
+    if (args.empty())
+    {
+        usage();
+        return 1;
+    }
+
+    if (args[0] == "--generate")
+    {
+        if (args.size() < 4)
+        {
+            usage();
+            return 1;
+        }
+        size_t orders;
+        double seconds;
+        try
+        {
+            orders = parseCount(args[2]);
+            seconds = parsePositive(args[3]);
+        }
+        catch (const logic_error&)
+        {
+            usage();
+            return 1;
+        }
+        OrderTrace trace = generateLunchRush(orders, seconds, {"Hamburger", "Cheeseburger", "CrispyChickenBurger"});
+        bool written = endsWith(args[1], ".csv") ? writeTraceCsv(trace, args[1]) : writeTraceBinary(trace, args[1]);
+        if (!written)
+        {
+            cout<<"Cannot write "<<args[1]<<endl;
+            return 1;
+        }
+        cout<<"Wrote "<<trace.orders.size()<<" orders to "<<args[1]<<endl;
+        return 0;
+    }
+
+    string menuPath;
+    bool recorded = false, verbose = false;
+    double speed = 1.0;
+    size_t cooks = 0;
+    try
+    {
+        for (size_t i = 1; i < args.size(); i++)
+        {
+            if (args[i] == "--recorded")
+                recorded = true;
+            else if (args[i] == "--verbose")
+                verbose = true;
+            else if (args[i] == "--speed" && i + 1 < args.size())
+                speed = parsePositive(args[++i]);
+            else if (args[i] == "--cooks" && i + 1 < args.size())
+                cooks = parseCount(args[++i]);
+            else if (args[i] == "--menu" && i + 1 < args.size())
+                menuPath = args[++i];
+            else
+            {
+                usage();
+                return 1;
+            }
+        }
+    }
+    catch (const logic_error&)
+    {
+        usage();
+        return 1;
+    }
+
+    OrderTrace trace;
+    if (!readTrace(args[0], trace))
+    {
+        cout<<"Cannot read trace "<<args[0]<<endl;
+        return 1;
+    }
+    if (!trace.badLines.empty())
+        cout<<"Skipped "<<trace.badLines.size()<<" line(s) with a bad timestamp, first at line "
+            <<trace.badLines.front()<<endl;
+
+    BurgerResolver burgers(menuPath);
+    OrderReplayer replayer(ref(burgers));
+    replayer.recordedSpeed = recorded;
+    replayer.speed = speed;
+    replayer.cooks = cooks;
+
+    ReplayReport report;
+    if (verbose)
+        report = replayer.replay(trace);
+    else
+    {
+        MuteCout mute;
+        report = replayer.replay(trace);
+    }
+    printReplayReport(report, recorded);
+    return 0;
+}
@@ -0,0 +1,364 @@
+#ifndef LAB_1_ORDERREPLAY_H
+#define LAB_1_ORDERREPLAY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#include "KitchenExecutor.h"
+#include "LatencyHistogram.h"
+#include "RecipeRegistry.h"
+
+
+struct TraceOrder{
+    uint64_t atMicros;
+    uint32_t burger;
+};
+
+//Timestamped orders in time order; burger is an index into names.
+//On disk it is either CSV ("timestamp_us,burger" per line) or the binary layout below.
+struct OrderTrace{
+    vector<string> names;
+    vector<TraceOrder> orders;
+    //CSV lines skipped for a missing or bad timestamp, numbered from 1
+    vector<size_t> badLines;
+
+    //Recorded traces are not always in order; equal timestamps keep their file order
+    void sortByTime()
+    {
+        stable_sort(orders.begin(), orders.end(),
+                    [](const TraceOrder& a, const TraceOrder& b){ return a.atMicros < b.atMicros; });
+    }
+
+    uint32_t nameIndex(const string& name)
+    {
+        for (size_t i = 0; i < names.size(); i++)
+            if (names[i] == name)
+                return uint32_t(i);
+        names.push_back(name);
+        return uint32_t(names.size() - 1);
+    }
+};
+
+
+//Binary trace: "BTRC", version, name count, names as (uint32 length, bytes), order count, orders.
+//Integers are written in host byte order.
+const char TRACE_MAGIC[4] = {'B', 'T', 'R', 'C'};
+const uint32_t TRACE_VERSION = 1;
+
+bool writeTraceBinary(const OrderTrace& trace, const string& path)
+{
+    ofstream out(path, ios::binary);
+    if (!out)
+        return false;
+    uint32_t nameCount = uint32_t(trace.names.size());
+    uint64_t orderCount = trace.orders.size();
+    out.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    out.write((const char*)&TRACE_VERSION, sizeof(TRACE_VERSION));
+    out.write((const char*)&nameCount, sizeof(nameCount));
+    for (auto& name : trace.names)
+    {
+        uint32_t length = uint32_t(name.size());
+        out.write((const char*)&length, sizeof(length));
+        out.write(name.data(), length);
+    }
+    out.write((const char*)&orderCount, sizeof(orderCount));
+    for (auto& order : trace.orders)
+    {
+        out.write((const char*)&order.atMicros, sizeof(order.atMicros));
+        out.write((const char*)&order.burger, sizeof(order.burger));
+    }
+    return bool(out);
+}
+
+//Every count and length is checked against what is left of the file before anything is
+//allocated, so a corrupt header fails instead of hanging or asking for gigabytes
+bool readTraceBinary(const string& path, OrderTrace& trace)
+{
+    ifstream in(path, ios::binary | ios::ate);
+    if (!in)
+        return false;
+    uint64_t fileSize = uint64_t(in.tellg());
+    in.seekg(0);
+    auto remaining = [&]() -> uint64_t
+    {
+        streamoff at = in.tellg();
+        return at < 0 || uint64_t(at) > fileSize ? 0 : fileSize - uint64_t(at);
+    };
+
+    char magic[4];
+    uint32_t version = 0, nameCount = 0;
+    uint64_t orderCount = 0;
+    if (!in.read(magic, sizeof(magic)) || memcmp(magic, TRACE_MAGIC, sizeof(magic)) != 0)
+        return false;
+    in.read((char*)&version, sizeof(version));
+    in.read((char*)&nameCount, sizeof(nameCount));
+    if (!in || version != TRACE_VERSION || nameCount > remaining() / sizeof(uint32_t))
+        return false;
+
+    OrderTrace loaded;
+    for (uint32_t i = 0; i < nameCount; i++)
+    {
+        uint32_t length = 0;
+        if (!in.read((char*)&length, sizeof(length)) || length > remaining())
+            return false;
+        string name(length, '\0');
+        if (!in.read(&name[0], length))
+            return false;
+        loaded.names.push_back(name);
+    }
+    const uint64_t orderBytes = sizeof(uint64_t) + sizeof(uint32_t);
+    if (!in.read((char*)&orderCount, sizeof(orderCount)) || orderCount > remaining() / orderBytes)
+        return false;
+    loaded.orders.resize(size_t(orderCount));
+    for (auto& order : loaded.orders)
+    {
+        in.read((char*)&order.atMicros, sizeof(order.atMicros));
+        in.read((char*)&order.burger, sizeof(order.burger));
+        if (!in)
+            return false;
+    }
+    loaded.sortByTime();
+    trace = move(loaded);
+    return true;
+}
+
+bool writeTraceCsv(const OrderTrace& trace, const string& path)
+{
+    ofstream out(path);
+    if (!out)
+        return false;
+    out<<"timestamp_us,burger\n";
+    for (auto& order : trace.orders)
+        out<<order.atMicros<<','<<trace.names[order.burger]<<'\n';
+    return bool(out);
+}
+
+bool readTraceCsv(const string& path, OrderTrace& trace)
+{
+    ifstream in(path);
+    if (!in)
+        return false;
+    trace = OrderTrace();
+    string line;
+    size_t lineNumber = 0;
+    while (getline(in, line))
+    {
+        lineNumber++;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.empty() || (lineNumber == 1 && line.compare(0, 13, "timestamp_us,") == 0))
+            continue;
+
+        size_t comma = line.find(',');
+        uint64_t at = 0;
+        bool valid = comma != string::npos && comma > 0;
+        for (size_t i = 0; valid && i < comma; i++)
+        {
+            unsigned digit = unsigned(line[i] - '0');
+            valid = digit <= 9 && at <= (UINT64_MAX - digit) / 10;
+            at = at * 10 + digit;
+        }
+        if (!valid)
+        {
+            trace.badLines.push_back(lineNumber);
+            continue;
+        }
+        trace.orders.push_back(TraceOrder{at, trace.nameIndex(line.substr(comma + 1))});
+    }
+    trace.sortByTime();
+    return true;
+}
+
+//Picks the format from the file itself, so .csv and binary traces both work.
+//A file with the binary magic is only read as binary, so a corrupt one fails.
+bool readTrace(const string& path, OrderTrace& trace)
+{
+    ifstream in(path, ios::binary);
+    char magic[4] = {};
+    in.read(magic, sizeof(magic));
+    if (in && memcmp(magic, TRACE_MAGIC, sizeof(magic)) == 0)
+        return readTraceBinary(path, trace);
+    return readTraceCsv(path, trace);
+}
+
+//Lunch rush: arrivals ramp up to a peak in the middle of the window and back down
+OrderTrace generateLunchRush(size_t orders, double seconds, const vector<string>& menu, uint32_t seed = 42)
+{
+    OrderTrace trace;
+    for (auto& name : menu)
+        trace.nameIndex(name);
+    mt19937 gen(seed);
+    normal_distribution<double> arrival(0.5, 0.15);
+    uniform_int_distribution<uint32_t> pick(0, uint32_t(menu.size() - 1));
+    for (size_t i = 0; i < orders; i++)
+    {
+        double at = arrival(gen);
+        at = at < 0 ? 0 : (at > 1 ? 1 : at);
+        trace.orders.push_back(TraceOrder{uint64_t(at * seconds * 1e6), pick(gen)});
+    }
+    trace.sortByTime();
+    return trace;
+}
+
+
+struct ReplayReport{
+    uint64_t orders = 0;
+    uint64_t unknown = 0;
+    double seconds = 0;
+    double ordersPerSecond = 0;
+    uint64_t lateP50 = 0;
+    uint64_t lateP99 = 0;
+    uint64_t lateMax = 0;
+};
+
+
+//Replays a trace against the IBurger hierarchy. With recordedSpeed the orders are released at
+//their timestamps (divided by speed) and lateness is how far behind schedule each one went out;
+//otherwise orders go out back to back. With cooks > 0 orders go to a KitchenExecutor.
+class OrderReplayer{
+private:
+    function<IBurger*(const string&)> resolve;
+
+public:
+    bool recordedSpeed = false;
+    double speed = 1.0;
+    size_t cooks = 0;
+
+    explicit OrderReplayer(function<IBurger*(const string&)> resolver)
+    {
+        resolve = resolver;
+    }
+
+    ReplayReport replay(const OrderTrace& trace)
+    {
+        ReplayReport report;
+        vector<IBurger*> burgers;
+        for (auto& name : trace.names)
+            burgers.push_back(resolve(name));
+
+        unique_ptr<KitchenExecutor> kitchen;
+        if (cooks > 0)
+            kitchen.reset(new KitchenExecutor(cooks));
+
+        LatencyHistogram lateness;
+        uint64_t firstAt = UINT64_MAX;
+        for (auto& order : trace.orders)
+            firstAt = min(firstAt, order.atMicros);
+        auto start = chrono::steady_clock::now();
+        for (auto& order : trace.orders)
+        {
+            IBurger* burger = order.burger < burgers.size() ? burgers[order.burger] : nullptr;
+            if (!burger)
+            {
+                report.unknown++;
+                continue;
+            }
+
+            auto due = start + chrono::microseconds(uint64_t((order.atMicros - firstAt) / speed));
+            auto now = chrono::steady_clock::now();
+            if (recordedSpeed)
+            {
+                if (now < due)
+                {
+                    this_thread::sleep_until(due);
+                    now = chrono::steady_clock::now();
+                }
+                lateness.record(now > due ? uint64_t(chrono::duration_cast<chrono::nanoseconds>(now - due).count()) : 0);
+            }
+
+            if (kitchen)
+                kitchen->submit(burger);
+            else
+                burger->makeBurger();
+            report.orders++;
+        }
+        if (kitchen)
+            kitchen->waitIdle();
+
+        report.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        report.ordersPerSecond = report.seconds > 0 ? report.orders / report.seconds : 0;
+        report.lateP50 = lateness.percentile(50);
+        report.lateP99 = lateness.percentile(99);
+        report.lateMax = lateness.max();
+        return report;
+    }
+};
+
+
+void printReplayReport(const ReplayReport& r, bool recordedSpeed)
+{
+    cout<<"Replayed "<<r.orders<<" orders in "<<r.seconds<<" s ("<<(uint64_t)r.ordersPerSecond<<" orders/s)";
+    if (r.unknown)
+        cout<<", "<<r.unknown<<" unknown burgers skipped";
+    cout<<endl;
+    if (recordedSpeed)
+        cout<<"Lateness: p50 "<<r.lateP50 / 1000.0<<" us, p99 "<<r.lateP99 / 1000.0<<" us, max "<<r.lateMax / 1000.0<<" us"<<endl;
+}
+
+
+//Built-in burgers first, then anything from the menu file
+class BurgerResolver{
+private:
+    Hamburger hamburger;
+    Cheeseburger cheeseburger;
+    Crispychickenburger crispychickenburger;
+    RecipeRegistry menu;
+
+public:
+    explicit BurgerResolver(const string& menuPath = "")
+    {
+        if (!menuPath.empty())
+            menu.loadFile(menuPath);
+    }
+
+    IBurger* operator()(const string& name)
+    {
+        if (name == "Hamburger")
+            return &hamburger;
+        if (name == "Cheeseburger")
+            return &cheeseburger;
+        if (name == "CrispyChickenBurger")
+            return &crispychickenburger;
+        return menu.find(name);
+    }
+};
+
+
+void OrderReplayDemo()
+{
+    OrderTrace rush = generateLunchRush(20000, 0.2, {"Hamburger", "Cheeseburger", "CrispyChickenBurger"});
+    writeTraceCsv(rush, "lunch_rush.csv");
+    writeTraceBinary(rush, "lunch_rush.trace");
+
+    OrderTrace fromCsv, fromBinary;
+    bool loaded = readTrace("lunch_rush.csv", fromCsv) && readTrace("lunch_rush.trace", fromBinary);
+    remove("lunch_rush.csv");
+    remove("lunch_rush.trace");
+    if (!loaded)
+    {
+        cout<<"Could not read the trace back"<<endl;
+        return;
+    }
+
+    BurgerResolver burgers;
+    OrderReplayer replayer(ref(burgers));
+    ReplayReport fast, recorded;
+    {
+        MuteCout mute;
+        fast = replayer.replay(fromCsv);
+        replayer.recordedSpeed = true;
+        recorded = replayer.replay(fromBinary);
+    }
+    cout<<"As fast as possible:"<<endl;
+    printReplayReport(fast, false);
+    cout<<"At recorded speed:"<<endl;
+    printReplayReport(recorded, true);
+}
+
+#endif //LAB_1_ORDERREPLAY_H
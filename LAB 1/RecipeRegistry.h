@@ -0,0 +1,322 @@
+#ifndef LAB_1_RECIPEREGISTRY_H
+#define LAB_1_RECIPEREGISTRY_H
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+#include "Bench.h"
+
+
+//Burger whose recipe comes from the menu file instead of a subclass
+class MenuBurger : public IBurger
+{
+private:
+    string name;
+    Recipe ingredients;
+
+    void addRange(Ingredient first, Ingredient last)
+    {
+        for (int i = first; i <= last; i++)
+            for (int n = 0; n < ingredients.amount[i]; n++)
+                cout<<"Adding "<<ingredientName(Ingredient(i))<<endl;
+    }
+
+public:
+    MenuBurger(string n, Recipe r)
+    {
+        name = n;
+        ingredients = r;
+    }
+
+    const string& getName() const
+    {
+        return name;
+    }
+
+    void makeBurger() override
+    {
+        cout<<"Making "<<name<<endl;
+        addBuns();
+        addPatty();
+        addToppings();
+        addSauce();
+    }
+
+    void addBuns() override
+    {
+        addRange(BUNS, BUNS);
+    }
+
+    void addPatty() override
+    {
+        addRange(BEEF_PATTY, CRISPY_CHICKEN_PATTY);
+    }
+
+    void addToppings() override
+    {
+        addRange(CHEESE, TOMATO);
+    }
+
+    void addSauce() override
+    {
+        addRange(KETCHUP, GARLIC_MAYO);
+    }
+
+    Recipe recipe() const override
+    {
+        return ingredients;
+    }
+};
+
+
+//Menu loaded at startup. Lines look like
+//    Cheeseburger: buns, beef patty, cheese, ketchup
+//Names are placed with a minimal perfect hash (hash and displace), so a lookup is
+//one bucket read, one slot read and one string compare.
+class RecipeRegistry{
+private:
+    vector<MenuBurger> burgers;
+    vector<int32_t> displacement;
+
+    static uint64_t hashName(const string& name, uint64_t seed)
+    {
+        uint64_t h = 14695981039346656037ULL ^ (seed * 0x9E3779B97F4A7C15ULL);
+        for (unsigned char c : name)
+        {
+            h ^= c;
+            h *= 1099511628211ULL;
+        }
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    static string trim(const string& s)
+    {
+        size_t first = s.find_first_not_of(" \t\r");
+        if (first == string::npos)
+            return "";
+        size_t last = s.find_last_not_of(" \t\r");
+        return s.substr(first, last - first + 1);
+    }
+
+    static bool parseIngredient(const string& name, Ingredient& ingredient)
+    {
+        for (int i = 0; i < INGREDIENT_COUNT; i++)
+            if (name == ingredientName(Ingredient(i)))
+            {
+                ingredient = Ingredient(i);
+                return true;
+            }
+        return false;
+    }
+
+    void build(vector<MenuBurger>& items)
+    {
+        size_t n = items.size();
+        burgers.clear();
+        displacement.assign(n, 0);
+        if (n == 0)
+            return;
+
+        vector<vector<size_t>> buckets(n);
+        for (size_t i = 0; i < n; i++)
+            buckets[hashName(items[i].getName(), 0) % n].push_back(i);
+
+        vector<size_t> order(n);
+        for (size_t b = 0; b < n; b++)
+            order[b] = b;
+        sort(order.begin(), order.end(), [&](size_t a, size_t b){ return buckets[a].size() > buckets[b].size(); });
+
+        vector<int64_t> slotOf(n, -1);
+        vector<bool> taken(n, false);
+        size_t b = 0;
+        //Buckets with collisions: search a seed that sends every name to a free slot
+        for (; b < n && buckets[order[b]].size() > 1; b++)
+        {
+            const vector<size_t>& bucket = buckets[order[b]];
+            vector<size_t> slots;
+            for (int32_t seed = 1; ; seed++)
+            {
+                slots.clear();
+                for (size_t item : bucket)
+                {
+                    size_t slot = hashName(items[item].getName(), seed) % n;
+                    if (taken[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end())
+                        break;
+                    slots.push_back(slot);
+                }
+                if (slots.size() == bucket.size())
+                {
+                    displacement[order[b]] = seed;
+                    break;
+                }
+            }
+            for (size_t i = 0; i < bucket.size(); i++)
+            {
+                taken[slots[i]] = true;
+                slotOf[bucket[i]] = slots[i];
+            }
+        }
+        //Single names go straight into the remaining slots, stored as -(slot + 1)
+        size_t freeSlot = 0;
+        for (; b < n && buckets[order[b]].size() == 1; b++)
+        {
+            while (taken[freeSlot])
+                freeSlot++;
+            taken[freeSlot] = true;
+            slotOf[buckets[order[b]][0]] = freeSlot;
+            displacement[order[b]] = -int32_t(freeSlot) - 1;
+        }
+
+        vector<size_t> itemAt(n);
+        for (size_t i = 0; i < n; i++)
+            itemAt[slotOf[i]] = i;
+        burgers.reserve(n);
+        for (size_t slot = 0; slot < n; slot++)
+            burgers.push_back(items[itemAt[slot]]);
+    }
+
+public:
+    //Replaces the current menu. Lines with unknown ingredients are reported and skipped.
+    bool load(istream& in)
+    {
+        vector<MenuBurger> items;
+        unordered_map<string, size_t> seen;
+        string line;
+        size_t lineNumber = 0;
+        bool ok = true;
+
+        while (getline(in, line))
+        {
+            lineNumber++;
+            line = trim(line);
+            if (line.empty() || line[0] == '#')
+                continue;
+
+            size_t colon = line.find(':');
+            string name = trim(line.substr(0, colon));
+            if (colon == string::npos || name.empty())
+            {
+                cout<<"Menu line "<<lineNumber<<": expected 'name: ingredient, ...'"<<endl;
+                ok = false;
+                continue;
+            }
+
+            Recipe recipe;
+            bool valid = true;
+            stringstream rest(line.substr(colon + 1));
+            string word;
+            while (getline(rest, word, ','))
+            {
+                Ingredient ingredient;
+                if (!parseIngredient(trim(word), ingredient))
+                {
+                    cout<<"Menu line "<<lineNumber<<": unknown ingredient '"<<trim(word)<<"'"<<endl;
+                    valid = false;
+                    break;
+                }
+                recipe.add(ingredient);
+            }
+            if (!valid)
+            {
+                ok = false;
+                continue;
+            }
+
+            auto found = seen.find(name);
+            if (found != seen.end())
+                items[found->second] = MenuBurger(name, recipe);
+            else
+            {
+                seen[name] = items.size();
+                items.emplace_back(name, recipe);
+            }
+        }
+
+        build(items);
+        return ok;
+    }
+
+    bool loadFile(const string& path)
+    {
+        ifstream file(path);
+        if (!file)
+        {
+            cout<<"Cannot open menu file "<<path<<endl;
+            return false;
+        }
+        return load(file);
+    }
+
+    IBurger* find(const string& name)
+    {
+        if (burgers.empty())
+            return nullptr;
+        size_t n = burgers.size();
+        int32_t d = displacement[hashName(name, 0) % n];
+        size_t slot = d < 0 ? size_t(-d - 1) : hashName(name, d) % n;
+        return burgers[slot].getName() == name ? &burgers[slot] : nullptr;
+    }
+
+    size_t size() const
+    {
+        return burgers.size();
+    }
+};
+
+
+void RecipeRegistryDemo()
+{
+    RecipeRegistry menu;
+    if (menu.loadFile("menu.txt"))
+    {
+        for (string name : {"Hamburger", "Cheeseburger", "CrispyChickenBurger", "DoubleCheeseburger"})
+        {
+            cout<<endl;
+            IBurger* burger = menu.find(name);
+            if (burger)
+                burger->makeBurger();
+        }
+    }
+
+    //Startup cost of a large menu
+    const size_t items = 10000;
+    const char* path = "menu_10k.txt";
+    {
+        ofstream big(path);
+        for (size_t i = 0; i < items; i++)
+        {
+            big<<"Burger #"<<i<<": buns, "<<(i % 2 ? "beef patty" : "crispy chicken patty");
+            for (int t = CHEESE; t < INGREDIENT_COUNT; t++)
+                if ((i >> t) & 1)
+                    big<<", "<<ingredientName(Ingredient(t));
+            big<<"\n";
+        }
+    }
+
+    RecipeRegistry bigMenu;
+    Stopwatch load;
+    bigMenu.loadFile(path);
+    double loadSeconds = load.seconds();
+    remove(path);
+
+    vector<string> names;
+    for (size_t i = 0; i < items; i++)
+        names.push_back("Burger #" + to_string(i));
+    size_t found = 0;
+    Stopwatch lookup;
+    for (int round = 0; round < 100; round++)
+        for (auto& name : names)
+            found += bigMenu.find(name) != nullptr;
+    double lookupSeconds = lookup.seconds();
+
+    cout<<endl<<"Loaded "<<bigMenu.size()<<" menu items in "<<loadSeconds * 1000<<" ms"<<endl;
+    cout<<found<<" lookups, "<<lookupSeconds * 1e9 / found<<" ns per lookup"<<endl;
+}
+
+#endif //LAB_1_RECIPEREGISTRY_H
@@ -0,0 +1,269 @@
+#ifndef LAB_1_ROLECOMPOSITION_H
+#define LAB_1_ROLECOMPOSITION_H
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "Bench.h"
+
+
+//Compile-time version of the ISP roles: every role is a policy class and an employee type is
+//the roles it inherits. Nothing is virtual, so when the employee type is known the calls are
+//resolved (and usually inlined) at compile time.
+
+//What the roles do with their message. ConsoleWork prints it like ISP.h does;
+//SinkWork only counts it, so benchmarks measure dispatch instead of iostream.
+struct ConsoleWork{
+    static void log(const char* message)
+    {
+        cout<<message<<endl;
+    }
+};
+
+uint64_t roleWorkCount = 0;
+
+struct SinkWork{
+    static void log(const char* message)
+    {
+        roleWorkCount++;
+        doNotOptimize(message);
+    }
+};
+
+
+template <class Work = ConsoleWork>
+class BackendRole{
+public:
+    void codeBackend()
+    {
+        Work::log("Coding Backend...");
+    }
+};
+
+template <class Work = ConsoleWork>
+class FrontendRole{
+public:
+    void codeFrontend()
+    {
+        Work::log("Coding Frontend...");
+    }
+};
+
+template <class Work = ConsoleWork>
+class DevOpsRole{
+public:
+    void deployApp()
+    {
+        Work::log("Deploying App...");
+    }
+};
+
+template <class Work = ConsoleWork>
+class NetworkRole{
+public:
+    void developNetwork()
+    {
+        Work::log("Developing network...");
+    }
+};
+
+
+template <class... Roles>
+class Employee : public Roles...
+{
+};
+
+typedef Employee<BackendRole<>, FrontendRole<>> StaticFullStackDev;
+typedef Employee<DevOpsRole<>> StaticDevOpsEngineer;
+typedef Employee<NetworkRole<>> StaticNetworkArchitect;
+
+
+//Detects which role calls a type supports
+template <class E, class = void>
+struct HasBackend : false_type {};
+template <class E>
+struct HasBackend<E, decltype(declval<E&>().codeBackend(), void())> : true_type {};
+
+template <class E, class = void>
+struct HasFrontend : false_type {};
+template <class E>
+struct HasFrontend<E, decltype(declval<E&>().codeFrontend(), void())> : true_type {};
+
+template <class E, class = void>
+struct HasDevOps : false_type {};
+template <class E>
+struct HasDevOps<E, decltype(declval<E&>().deployApp(), void())> : true_type {};
+
+template <class E, class = void>
+struct HasNetwork : false_type {};
+template <class E>
+struct HasNetwork<E, decltype(declval<E&>().developNetwork(), void())> : true_type {};
+
+
+//Function pointer for each role call, or null when the type lacks the role.
+//The specialization holding the call is only instantiated for types that have it.
+typedef void (*RoleCall)(void*);
+
+template <class E, bool has = HasBackend<E>::value>
+struct BackendCall { static RoleCall get() { return nullptr; } };
+template <class E>
+struct BackendCall<E, true> { static RoleCall get() { return [](void* e){ static_cast<E*>(e)->codeBackend(); }; } };
+
+template <class E, bool has = HasFrontend<E>::value>
+struct FrontendCall { static RoleCall get() { return nullptr; } };
+template <class E>
+struct FrontendCall<E, true> { static RoleCall get() { return [](void* e){ static_cast<E*>(e)->codeFrontend(); }; } };
+
+template <class E, bool has = HasDevOps<E>::value>
+struct DevOpsCall { static RoleCall get() { return nullptr; } };
+template <class E>
+struct DevOpsCall<E, true> { static RoleCall get() { return [](void* e){ static_cast<E*>(e)->deployApp(); }; } };
+
+template <class E, bool has = HasNetwork<E>::value>
+struct NetworkCall { static RoleCall get() { return nullptr; } };
+template <class E>
+struct NetworkCall<E, true> { static RoleCall get() { return [](void* e){ static_cast<E*>(e)->developNetwork(); }; } };
+
+
+//Type-erased handle for mixed teams. Each employee type gets one static table of
+//function pointers; a role the type lacks is a null entry.
+class EmployeeHandle{
+private:
+    struct Ops{
+        RoleCall codeBackend;
+        RoleCall codeFrontend;
+        RoleCall deployApp;
+        RoleCall developNetwork;
+        RoleCall destroy;
+        void* (*copy)(const void*);
+    };
+
+    template <class E>
+    static const Ops* opsFor()
+    {
+        static const Ops ops = {
+                BackendCall<E>::get(),
+                FrontendCall<E>::get(),
+                DevOpsCall<E>::get(),
+                NetworkCall<E>::get(),
+                [](void* e){ delete static_cast<E*>(e); },
+                [](const void* e) -> void* { return new E(*static_cast<const E*>(e)); }
+        };
+        return &ops;
+    }
+
+    void* self;
+    const Ops* ops;
+
+public:
+    template <class E>
+    EmployeeHandle(E employee)
+    {
+        self = new E(move(employee));
+        ops = opsFor<E>();
+    }
+
+    EmployeeHandle(const EmployeeHandle& other)
+    {
+        self = other.ops->copy(other.self);
+        ops = other.ops;
+    }
+
+    EmployeeHandle& operator=(EmployeeHandle other)
+    {
+        swap(self, other.self);
+        swap(ops, other.ops);
+        return *this;
+    }
+
+    ~EmployeeHandle()
+    {
+        ops->destroy(self);
+    }
+
+    bool canCodeBackend() const { return ops->codeBackend != nullptr; }
+    bool canCodeFrontend() const { return ops->codeFrontend != nullptr; }
+    bool canDeployApp() const { return ops->deployApp != nullptr; }
+    bool canDevelopNetwork() const { return ops->developNetwork != nullptr; }
+
+    //A role the employee lacks does nothing
+    void codeBackend() { if (ops->codeBackend) ops->codeBackend(self); }
+    void codeFrontend() { if (ops->codeFrontend) ops->codeFrontend(self); }
+    void deployApp() { if (ops->deployApp) ops->deployApp(self); }
+    void developNetwork() { if (ops->developNetwork) ops->developNetwork(self); }
+};
+
+
+//The ISP.h interfaces with the same cheap body, for a fair comparison
+class SinkFullStackDev : public IBackend, public IFrontend
+{
+public:
+    void codeBackend() override
+    {
+        SinkWork::log("Coding Backend...");
+    }
+
+    void codeFrontend() override
+    {
+        SinkWork::log("Coding Frontend...");
+    }
+};
+
+
+void RoleCompositionDemo()
+{
+    Employee<BackendRole<>, FrontendRole<>, DevOpsRole<>> fullStackDevOps;
+    fullStackDevOps.codeBackend();
+    fullStackDevOps.deployApp();
+
+    vector<EmployeeHandle> team = {StaticFullStackDev(), StaticDevOpsEngineer(), StaticNetworkArchitect()};
+    for (auto& member : team)
+    {
+        if (member.canCodeBackend())
+            member.codeBackend();
+        if (member.canDeployApp())
+            member.deployApp();
+        if (member.canDevelopNetwork())
+            member.developNetwork();
+    }
+
+    //Dispatch cost: the same codeBackend call through each mechanism
+    const size_t teamSize = 1000;
+    const size_t rounds = 2000;
+    typedef Employee<BackendRole<SinkWork>, FrontendRole<SinkWork>> Composed;
+
+    vector<SinkFullStackDev> virtualDevs(teamSize);
+    vector<IBackend*> virtualTeam;
+    for (auto& dev : virtualDevs)
+        virtualTeam.push_back(&dev);
+    vector<Composed> staticTeam(teamSize);
+    vector<EmployeeHandle> erasedTeam(teamSize, EmployeeHandle(Composed()));
+
+    Stopwatch clock;
+    for (size_t r = 0; r < rounds; r++)
+        for (auto dev : virtualTeam)
+            dev->codeBackend();
+    double virtualSeconds = clock.seconds();
+
+    clock.reset();
+    for (size_t r = 0; r < rounds; r++)
+        for (auto& dev : staticTeam)
+            dev.codeBackend();
+    double staticSeconds = clock.seconds();
+
+    clock.reset();
+    for (size_t r = 0; r < rounds; r++)
+        for (auto& dev : erasedTeam)
+            dev.codeBackend();
+    double erasedSeconds = clock.seconds();
+
+    double calls = double(teamSize * rounds);
+    cout<<endl<<"codeBackend x"<<(uint64_t)calls<<":"<<endl;
+    cout<<"  virtual IBackend*:    "<<virtualSeconds * 1e9 / calls<<" ns/call"<<endl;
+    cout<<"  composed (static):    "<<staticSeconds * 1e9 / calls<<" ns/call"<<endl;
+    cout<<"  EmployeeHandle:       "<<erasedSeconds * 1e9 / calls<<" ns/call"<<endl;
+    cout<<"  ("<<roleWorkCount<<" calls counted)"<<endl;
+}
+
+#endif //LAB_1_ROLECOMPOSITION_H
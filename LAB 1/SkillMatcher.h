@@ -0,0 +1,223 @@
+#ifndef LAB_1_SKILLMATCHER_H
+#define LAB_1_SKILLMATCHER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+
+#include "Bench.h"
+#include "CapabilityScheduler.h"
+
+
+//128 skills; the first CAPABILITY_COUNT bits are the ISP role interfaces
+struct SkillSet{
+    static const int WORDS = 2;
+    static const int SKILL_COUNT = 64 * WORDS;
+
+    uint64_t words[WORDS] = {};
+
+    SkillSet& add(int skill)
+    {
+        words[skill / 64] |= uint64_t(1) << (skill % 64);
+        return *this;
+    }
+
+    SkillSet& add(Capability capability)
+    {
+        return add(int(capability));
+    }
+
+    static SkillSet of(const RoleWorker& worker)
+    {
+        SkillSet skills;
+        for (int c = 0; c < CAPABILITY_COUNT; c++)
+            if (worker.can(Capability(c)))
+                skills.add(Capability(c));
+        return skills;
+    }
+
+    bool operator==(const SkillSet& other) const
+    {
+        for (int w = 0; w < WORDS; w++)
+            if (words[w] != other.words[w])
+                return false;
+        return true;
+    }
+};
+
+struct SkillSetHash{
+    size_t operator()(const SkillSet& s) const
+    {
+        uint64_t h = 0;
+        for (int w = 0; w < SkillSet::WORDS; w++)
+            h = (h ^ s.words[w]) * 0x9E3779B97F4A7C15ULL;
+        return size_t(h ^ (h >> 29));
+    }
+};
+
+
+struct AssignmentReport{
+    uint64_t assigned = 0;
+    uint64_t unassigned = 0;
+    size_t uniqueMasks = 0;
+    double seconds = 0;
+    double assignmentsPerSecond = 0;
+};
+
+
+//Matches tasks to employees by required-skill mask.
+//Employee skills are stored word by word (all first words, then all second words), so a scan for
+//one mask is a straight AND/compare pass over each array that the compiler can vectorize.
+//Greedy best fit: qualified employees are ranked by how many skills they have beyond what the
+//task needs (popcount of the surplus), and each task goes to the least over-qualified employee
+//that still has capacity. Candidate lists are cached per distinct mask, and since loads only grow,
+//each list is walked forward once.
+class SkillMatcher{
+private:
+    struct Candidates{
+        vector<uint32_t> ids;
+        size_t cursor = 0;
+    };
+
+    vector<uint64_t> skillWords[SkillSet::WORDS];
+    vector<uint32_t> load;
+    uint32_t capacity;
+    unordered_map<SkillSet, Candidates, SkillSetHash> candidates;
+
+    Candidates scan(const SkillSet& need) const
+    {
+        size_t n = load.size();
+        vector<uint8_t> qualified(n, 1);
+        for (int w = 0; w < SkillSet::WORDS; w++)
+        {
+            const uint64_t* words = skillWords[w].data();
+            uint64_t mask = need.words[w];
+            uint8_t* q = qualified.data();
+            for (size_t i = 0; i < n; i++)
+                q[i] &= uint8_t((words[i] & mask) == mask);
+        }
+
+        vector<pair<uint32_t, uint32_t>> ranked;
+        for (size_t i = 0; i < n; i++)
+        {
+            if (!qualified[i])
+                continue;
+            uint32_t surplus = 0;
+            for (int w = 0; w < SkillSet::WORDS; w++)
+                surplus += uint32_t(__builtin_popcountll(skillWords[w][i] & ~need.words[w]));
+            ranked.emplace_back(surplus, uint32_t(i));
+        }
+        sort(ranked.begin(), ranked.end());
+
+        Candidates c;
+        c.ids.reserve(ranked.size());
+        for (auto& r : ranked)
+            c.ids.push_back(r.second);
+        return c;
+    }
+
+public:
+    SkillMatcher(const vector<SkillSet>& employees, uint32_t tasksPerEmployee)
+    {
+        capacity = tasksPerEmployee;
+        for (int w = 0; w < SkillSet::WORDS; w++)
+        {
+            skillWords[w].reserve(employees.size());
+            for (auto& e : employees)
+                skillWords[w].push_back(e.words[w]);
+        }
+        load.assign(employees.size(), 0);
+    }
+
+    //Returns the employee index, or -1 if every qualified employee is full
+    int64_t assign(const SkillSet& need)
+    {
+        auto found = candidates.find(need);
+        if (found == candidates.end())
+            found = candidates.emplace(need, scan(need)).first;
+
+        Candidates& c = found->second;
+        while (c.cursor < c.ids.size() && load[c.ids[c.cursor]] >= capacity)
+            c.cursor++;
+        if (c.cursor == c.ids.size())
+            return -1;
+        uint32_t id = c.ids[c.cursor];
+        load[id]++;
+        return id;
+    }
+
+    AssignmentReport assignAll(const vector<SkillSet>& tasks, vector<int64_t>& assignment)
+    {
+        AssignmentReport report;
+        assignment.resize(tasks.size());
+        Stopwatch clock;
+        for (size_t t = 0; t < tasks.size(); t++)
+        {
+            assignment[t] = assign(tasks[t]);
+            if (assignment[t] < 0)
+                report.unassigned++;
+            else
+                report.assigned++;
+        }
+        report.seconds = clock.seconds();
+        report.assignmentsPerSecond = report.seconds > 0 ? tasks.size() / report.seconds : 0;
+        report.uniqueMasks = candidates.size();
+        return report;
+    }
+
+    uint32_t loadOf(size_t employee) const
+    {
+        return load[employee];
+    }
+};
+
+
+void SkillMatcherDemo()
+{
+    FullStackDev fullStackDev;
+    DevOpsEngineer devOpsEngineer;
+    NetworkArchitect networkArchitect;
+    vector<RoleWorker> roles = {
+            RoleWorker("FullStackDev", &fullStackDev),
+            RoleWorker("DevOpsEngineer", &devOpsEngineer),
+            RoleWorker("NetworkArchitect", &networkArchitect)
+    };
+
+    mt19937 gen(11);
+    const int commonSkills = 12;
+    auto extraSkill = [&](int spread) { return CAPABILITY_COUNT + int(gen() % spread); };
+
+    //Employees: one of the ISP role sets plus a handful of extra skills
+    vector<SkillSet> employees;
+    for (size_t i = 0; i < 5000; i++)
+    {
+        SkillSet skills = SkillSet::of(roles[i % roles.size()]);
+        for (int k = int(gen() % 10); k > 0; k--)
+            skills.add(extraSkill(k % 2 ? commonSkills : SkillSet::SKILL_COUNT - CAPABILITY_COUNT));
+        employees.push_back(skills);
+    }
+
+    //Tasks: one role plus up to two common skills; most work is backend
+    vector<SkillSet> tasks;
+    for (size_t i = 0; i < 300000; i++)
+    {
+        uint32_t roll = gen() % 10;
+        Capability need = roll < 6 ? BACKEND : (roll < 8 ? FRONTEND : (roll < 9 ? DEVOPS : NETWORK));
+        SkillSet skills;
+        skills.add(need);
+        for (int k = int(gen() % 3); k > 0; k--)
+            skills.add(extraSkill(commonSkills));
+        tasks.push_back(skills);
+    }
+
+    SkillMatcher matcher(employees, uint32_t(2 * tasks.size() / employees.size()));
+    vector<int64_t> assignment;
+    AssignmentReport r = matcher.assignAll(tasks, assignment);
+
+    cout<<employees.size()<<" employees, "<<tasks.size()<<" tasks, "<<r.uniqueMasks<<" distinct skill masks"<<endl;
+    cout<<"Assigned "<<r.assigned<<", unassigned "<<r.unassigned<<" in "<<r.seconds * 1000<<" ms ("
+        <<(uint64_t)r.assignmentsPerSecond<<" assignments/s)"<<endl;
+}
+
+#endif //LAB_1_SKILLMATCHER_H
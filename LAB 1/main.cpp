@@ -7,6 +7,17 @@ using namespace std;
 #include "SRP.h"
 #include "OCP.h"
 #include "ISP.h"
+#include "KitchenExecutor.h"
+#include "AssemblyPipeline.h"
+#include "Inventory.h"
+#include "RecipeRegistry.h"
+#include "LatencyHistogram.h"
+#include "OrderReplay.h"
+#include "KitchenSimulator.h"
+#include "CustomOrder.h"
+#include "CapabilityScheduler.h"
+#include "RoleComposition.h"
+#include "SkillMatcher.h"
 
 int main(){
 
@@ -20,10 +31,43 @@ OCP_before();
 cout<<endl<<"OCP - AFTER:"<<endl;
 OCP_after();
 
+cout<<endl<<"OCP - KITCHEN EXECUTOR:"<<endl;
+KitchenExecutorDemo();
+
+cout<<endl<<"OCP - ASSEMBLY PIPELINE:"<<endl;
+AssemblyPipelineDemo();
+
+cout<<endl<<"OCP - INGREDIENT INVENTORY:"<<endl;
+InventoryDemo();
+
+cout<<endl<<"OCP - RECIPE REGISTRY:"<<endl;
+RecipeRegistryDemo();
+
+cout<<endl<<"OCP - LATENCY HISTOGRAMS:"<<endl;
+LatencyHistogramDemo();
+
+cout<<endl<<"OCP - ORDER REPLAY:"<<endl;
+OrderReplayDemo();
+
+cout<<endl<<"OCP - KITCHEN SIMULATOR:"<<endl;
+KitchenSimulatorDemo();
+
+cout<<endl<<"OCP - CUSTOM ORDERS:"<<endl;
+CustomOrderDemo();
+
 cout<<endl<<"ISP - BEFORE:"<<endl;
 ISP_before();
 cout<<endl<<"ISP - AFTER:"<<endl;
 ISP_after();
 
+cout<<endl<<"ISP - CAPABILITY SCHEDULER:"<<endl;
+CapabilitySchedulerDemo();
+
+cout<<endl<<"ISP - ROLE COMPOSITION:"<<endl;
+RoleCompositionDemo();
+
+cout<<endl<<"ISP - SKILL MATCHER:"<<endl;
+SkillMatcherDemo();
+
     return 0;
 }
\ No newline at end of file
@@ -2,10 +2,14 @@
 #ifndef LAB_2_ABSTRACTFACTORY_H
 #define LAB_2_ABSTRACTFACTORY_H
 
+#include "Bench.h"
+#include "WeaponPool.h"
+
 
 class PrimaryWeapon{
 public:
     virtual void equipPrimary() = 0;
+    virtual const char* name() const = 0;
     virtual ~PrimaryWeapon() = default;
 };
 
@@ -13,83 +17,308 @@ public:
 class SecondaryWeapon{
 public:
     virtual void equipSecondary() = 0;
+    virtual const char* name() const = 0;
     virtual ~SecondaryWeapon() = default;
 };
 
+//The concrete weapons are final, so calls on a known weapon type need no vtable
 class MachineGun : public PrimaryWeapon{
-    void equipPrimary() override
+public:
+    void equipPrimary() override final
     {
         cout<<"Equipping Primary : Machine Gun";
     }
+
+    const char* name() const override final
+    {
+        return "Machine Gun";
+    }
 };
 
 class Pistol : public SecondaryWeapon{
-    void equipSecondary() override
+public:
+    void equipSecondary() override final
     {
         cout<<"Equipping Secondary : Pistol";
     }
+
+    const char* name() const override final
+    {
+        return "Pistol";
+    }
 };
 
 class SubMachineGun : public PrimaryWeapon
 {
-    void equipPrimary() override
+public:
+    void equipPrimary() override final
     {
         cout<<"Equipping Primary : SubMachine Gun";
     }
+
+    const char* name() const override final
+    {
+        return "SubMachine Gun";
+    }
 };
 
 class ATLauncher : public SecondaryWeapon
 {
-    void equipSecondary() override{
+public:
+    void equipSecondary() override final{
         cout<<"Equipping Secondary : AT Launcher";
     }
+
+    const char* name() const override final
+    {
+        return "AT Launcher";
+    }
+};
+
+
+//Weapons come back from their pool when the handle goes out of scope
+typedef unique_ptr<PrimaryWeapon, Recycler<PrimaryWeapon>> PrimaryHandle;
+typedef unique_ptr<SecondaryWeapon, Recycler<SecondaryWeapon>> SecondaryHandle;
+
+
+//A whole squad's kits in struct-of-arrays form: all primaries in one array, all secondaries
+//in another, so equipping or walking the squad is a linear pass over each
+class KitBatch{
+public:
+    virtual size_t size() const = 0;
+    virtual PrimaryWeapon& primary(size_t i) = 0;
+    virtual SecondaryWeapon& secondary(size_t i) = 0;
+    virtual void equipAll() = 0;
+    virtual ~KitBatch() = default;
+};
+
+template <class Primary, class Secondary>
+class TypedKitBatch : public KitBatch{
+private:
+    vector<Primary> primaries;
+    vector<Secondary> secondaries;
+
+public:
+    explicit TypedKitBatch(size_t n) : primaries(n), secondaries(n)
+    {
+    }
+
+    size_t size() const override
+    {
+        return primaries.size();
+    }
+
+    Primary& primary(size_t i) override
+    {
+        return primaries[i];
+    }
+
+    Secondary& secondary(size_t i) override
+    {
+        return secondaries[i];
+    }
+
+    void equipAll() override
+    {
+        for (size_t i = 0; i < primaries.size(); i++)
+        {
+            primaries[i].equipPrimary();
+            cout<<", ";
+            secondaries[i].equipSecondary();
+            cout<<endl;
+        }
+    }
+};
+
+
+//Kits made one at a time through makePrimary/makeSecondary, for factories without a batch layout
+class HandleKitBatch : public KitBatch{
+private:
+    vector<PrimaryHandle> primaries;
+    vector<SecondaryHandle> secondaries;
+
+public:
+    template <class Factory>
+    HandleKitBatch(Factory& factory, size_t n)
+    {
+        primaries.reserve(n);
+        secondaries.reserve(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            primaries.push_back(factory.makePrimary());
+            secondaries.push_back(factory.makeSecondary());
+        }
+    }
+
+    size_t size() const override
+    {
+        return primaries.size();
+    }
+
+    PrimaryWeapon& primary(size_t i) override
+    {
+        return *primaries[i];
+    }
+
+    SecondaryWeapon& secondary(size_t i) override
+    {
+        return *secondaries[i];
+    }
+
+    void equipAll() override
+    {
+        for (size_t i = 0; i < primaries.size(); i++)
+        {
+            primaries[i]->equipPrimary();
+            cout<<", ";
+            secondaries[i]->equipSecondary();
+            cout<<endl;
+        }
+    }
 };
 
 
 class KitFactory{
 public:
-    virtual PrimaryWeapon* makePrimary() = 0;
-    virtual SecondaryWeapon* makeSecondary() = 0;
+    virtual PrimaryHandle makePrimary() = 0;
+    virtual SecondaryHandle makeSecondary() = 0;
+    //n kits. By default they are made one by one; the built-in factories override this to lay
+    //them out in three allocations, however large n is
+    virtual unique_ptr<KitBatch> makeKits(size_t n)
+    {
+        return unique_ptr<KitBatch>(new HandleKitBatch(*this, n));
+    }
+    //Reserves pool room for this many kits, so the first rounds don't allocate either.
+    //Does nothing unless the factory pools its weapons.
+    virtual void prewarm(size_t)
+    {
+    }
     virtual ~KitFactory() = default;
 };
 
 
 class MGKitFactory : public KitFactory{
-    PrimaryWeapon* makePrimary() override
+public:
+    PrimaryHandle makePrimary() override
+    {
+        return WeaponPool<MachineGun>::instance().make<PrimaryWeapon>();
+    }
+
+    SecondaryHandle makeSecondary() override
+    {
+        return WeaponPool<Pistol>::instance().make<SecondaryWeapon>();
+    }
+
+    unique_ptr<KitBatch> makeKits(size_t n) override
     {
-        return new MachineGun;
+        return unique_ptr<KitBatch>(new TypedKitBatch<MachineGun, Pistol>(n));
     }
 
-    SecondaryWeapon* makeSecondary() override
+    void prewarm(size_t kits) override
     {
-        return new Pistol;
+        WeaponPool<MachineGun>::instance().prewarm(kits);
+        WeaponPool<Pistol>::instance().prewarm(kits);
     }
 };
 
 
 class ATKitFactory : public KitFactory{
+public:
+    PrimaryHandle makePrimary() override
+    {
+        return WeaponPool<SubMachineGun>::instance().make<PrimaryWeapon>();
+    }
+
+    SecondaryHandle makeSecondary() override
+    {
+        return WeaponPool<ATLauncher>::instance().make<SecondaryWeapon>();
+    }
 
-    PrimaryWeapon* makePrimary() override
+    unique_ptr<KitBatch> makeKits(size_t n) override
     {
-        return new SubMachineGun;
+        return unique_ptr<KitBatch>(new TypedKitBatch<SubMachineGun, ATLauncher>(n));
     }
 
-    SecondaryWeapon* makeSecondary() override
+    void prewarm(size_t kits) override
     {
-        return new ATLauncher;
+        WeaponPool<SubMachineGun>::instance().prewarm(kits);
+        WeaponPool<ATLauncher>::instance().prewarm(kits);
     }
 
 };
 
 
+//Kit factory resolved at compile time: weapons are made by value and every call is direct
+template <class Primary, class Secondary>
+class StaticKitFactory{
+public:
+    Primary makePrimary() const
+    {
+        return Primary();
+    }
+
+    Secondary makeSecondary() const
+    {
+        return Secondary();
+    }
+
+    TypedKitBatch<Primary, Secondary> makeKits(size_t n) const
+    {
+        return TypedKitBatch<Primary, Secondary>(n);
+    }
+
+    void equipKit() const
+    {
+        Primary primary = makePrimary();
+        Secondary secondary = makeSecondary();
+        primary.equipPrimary();
+        cout<<", ";
+        secondary.equipSecondary();
+        cout<<endl;
+    }
+};
+
+typedef StaticKitFactory<MachineGun, Pistol> StaticMGKitFactory;
+typedef StaticKitFactory<SubMachineGun, ATLauncher> StaticATKitFactory;
+
+
+//Exposes a static kit as a KitFactory for when the kit is only chosen at runtime
+template <class Primary, class Secondary>
+class StaticKitAdapter : public KitFactory{
+public:
+    PrimaryHandle makePrimary() override
+    {
+        return WeaponPool<Primary>::instance().template make<PrimaryWeapon>();
+    }
+
+    SecondaryHandle makeSecondary() override
+    {
+        return WeaponPool<Secondary>::instance().template make<SecondaryWeapon>();
+    }
+
+    unique_ptr<KitBatch> makeKits(size_t n) override
+    {
+        return unique_ptr<KitBatch>(new TypedKitBatch<Primary, Secondary>(n));
+    }
+
+    void prewarm(size_t kits) override
+    {
+        WeaponPool<Primary>::instance().prewarm(kits);
+        WeaponPool<Secondary>::instance().prewarm(kits);
+    }
+};
+
+
 void AbstractFactoryDemo()
 {
-    vector<KitFactory*> kits = { new MGKitFactory(), new ATKitFactory() };
+    vector<unique_ptr<KitFactory>> kits;
+    kits.emplace_back(new MGKitFactory());
+    kits.emplace_back(new ATKitFactory());
 
-    for (auto kit : kits)
+    for (auto& kit : kits)
     {
-        PrimaryWeapon* primary = kit->makePrimary();
-        SecondaryWeapon* secondary = kit->makeSecondary();
+        PrimaryHandle primary = kit->makePrimary();
+        SecondaryHandle secondary = kit->makeSecondary();
         primary->equipPrimary();
         cout<<", ";
         secondary->equipSecondary();
@@ -98,7 +327,211 @@ void AbstractFactoryDemo()
 }
 
 
+//Every round each squad member gets a kit, and the kits are dropped at the end of the round
+void KitPoolDemo()
+{
+    const size_t squad = 64;
+    const size_t rounds = 20000;
+
+    vector<unique_ptr<KitFactory>> kits;
+    kits.emplace_back(new MGKitFactory());
+    kits.emplace_back(new ATKitFactory());
+    for (auto& kit : kits)
+        kit->prewarm(squad);
+    PoolCounters warm = poolCounters;
+
+    vector<PrimaryHandle> primaries;
+    vector<SecondaryHandle> secondaries;
+    primaries.reserve(squad);
+    secondaries.reserve(squad);
+
+    Stopwatch pooled;
+    for (size_t r = 0; r < rounds; r++)
+    {
+        for (size_t i = 0; i < squad; i++)
+        {
+            primaries.push_back(kits[i % kits.size()]->makePrimary());
+            secondaries.push_back(kits[i % kits.size()]->makeSecondary());
+        }
+        primaries.clear();
+        secondaries.clear();
+    }
+    double pooledSeconds = pooled.seconds();
+
+    //The same rounds with plain new/delete, for comparison
+    vector<unique_ptr<PrimaryWeapon>> newPrimaries;
+    vector<unique_ptr<SecondaryWeapon>> newSecondaries;
+    newPrimaries.reserve(squad);
+    newSecondaries.reserve(squad);
 
+    Stopwatch heap;
+    for (size_t r = 0; r < rounds; r++)
+    {
+        for (size_t i = 0; i < squad; i++)
+        {
+            if (i % 2 == 0)
+            {
+                newPrimaries.emplace_back(new MachineGun);
+                newSecondaries.emplace_back(new Pistol);
+            }
+            else
+            {
+                newPrimaries.emplace_back(new SubMachineGun);
+                newSecondaries.emplace_back(new ATLauncher);
+            }
+        }
+        newPrimaries.clear();
+        newSecondaries.clear();
+    }
+    double heapSeconds = heap.seconds();
+
+    double weapons = double(2 * squad * rounds);
+    cout<<rounds<<" rounds x "<<squad<<" kits"<<endl;
+    cout<<"Warm-up: "<<warm.heapAllocations<<" heap allocations"<<endl;
+    cout<<"Steady state: "<<poolCounters.heapAllocations - warm.heapAllocations<<" heap allocations, "
+        <<poolCounters.acquired - warm.acquired<<" weapons made, "<<poolCounters.recycled - warm.recycled<<" recycled"<<endl;
+    cout<<"Pooled: "<<pooledSeconds * 1e9 / weapons<<" ns/weapon, new/delete: "<<heapSeconds * 1e9 / weapons<<" ns/weapon"<<endl;
+}
 
 
+//Spawns kits and reads the weapon names, which is all a spawn loop needs from them
+template <class Factory>
+uint64_t spawnStatic(const Factory& factory, size_t kits)
+{
+    uint64_t checksum = 0;
+    for (size_t i = 0; i < kits; i++)
+    {
+        auto primary = factory.makePrimary();
+        auto secondary = factory.makeSecondary();
+        checksum += uint64_t(primary.name()[i % 4]) + uint64_t(secondary.name()[i % 4]);
+    }
+    return checksum;
+}
+
+uint64_t spawnVirtual(KitFactory& factory, size_t kits)
+{
+    uint64_t checksum = 0;
+    for (size_t i = 0; i < kits; i++)
+    {
+        PrimaryHandle primary = factory.makePrimary();
+        SecondaryHandle secondary = factory.makeSecondary();
+        checksum += uint64_t(primary->name()[i % 4]) + uint64_t(secondary->name()[i % 4]);
+    }
+    return checksum;
+}
+
+
+void StaticKitFactoryDemo()
+{
+    StaticMGKitFactory mgKit;
+    StaticATKitFactory atKit;
+    mgKit.equipKit();
+    atKit.equipKit();
+
+    //Runtime choice through the adapter
+    vector<unique_ptr<KitFactory>> kits;
+    kits.emplace_back(new StaticKitAdapter<MachineGun, Pistol>());
+    kits.emplace_back(new StaticKitAdapter<SubMachineGun, ATLauncher>());
+    for (auto& kit : kits)
+    {
+        PrimaryHandle primary = kit->makePrimary();
+        SecondaryHandle secondary = kit->makeSecondary();
+        primary->equipPrimary();
+        cout<<", ";
+        secondary->equipSecondary();
+        cout<<endl;
+    }
+
+    const size_t spawns = 2000000;
+    MGKitFactory virtualKit;
+    StaticKitAdapter<MachineGun, Pistol> adaptedKit;
+    virtualKit.prewarm(1);
+
+    Stopwatch clock;
+    uint64_t checksum = spawnVirtual(virtualKit, spawns);
+    double virtualSeconds = clock.seconds();
+
+    clock.reset();
+    checksum += spawnVirtual(adaptedKit, spawns);
+    double adaptedSeconds = clock.seconds();
+
+    clock.reset();
+    checksum += spawnStatic(mgKit, spawns);
+    double staticSeconds = clock.seconds();
+
+    cout<<endl<<spawns<<" kit spawns (checksum "<<checksum<<"):"<<endl;
+    cout<<"  MGKitFactory via KitFactory&:      "<<virtualSeconds * 1e9 / spawns<<" ns/kit"<<endl;
+    cout<<"  StaticKitAdapter via KitFactory&:  "<<adaptedSeconds * 1e9 / spawns<<" ns/kit"<<endl;
+    cout<<"  StaticKitFactory:                  "<<staticSeconds * 1e9 / spawns<<" ns/kit"<<endl;
+}
+
+//Waves of 10k kits: spawn, walk the squad reading names, drop the wave
+void KitBatchDemo()
+{
+    MGKitFactory factory;
+    unique_ptr<KitBatch> fireteam = factory.makeKits(2);
+    fireteam->equipAll();
+
+    const size_t wave = 10000;
+    const size_t waves = 200;
+    factory.prewarm(wave);
+    uint64_t checksum = 0;
+
+    //One primary and one secondary per call, from the pools
+    vector<PrimaryHandle> primaries;
+    vector<SecondaryHandle> secondaries;
+    primaries.reserve(wave);
+    secondaries.reserve(wave);
+    Stopwatch clock;
+    for (size_t w = 0; w < waves; w++)
+    {
+        for (size_t i = 0; i < wave; i++)
+        {
+            primaries.push_back(factory.makePrimary());
+            secondaries.push_back(factory.makeSecondary());
+        }
+        for (size_t i = 0; i < wave; i++)
+            checksum += uint64_t(primaries[i]->name()[0]) + uint64_t(secondaries[i]->name()[0]);
+        primaries.clear();
+        secondaries.clear();
+    }
+    double perKitSeconds = clock.seconds();
+
+    //The same with plain new/delete, as the factory used to do
+    vector<unique_ptr<PrimaryWeapon>> newPrimaries;
+    vector<unique_ptr<SecondaryWeapon>> newSecondaries;
+    newPrimaries.reserve(wave);
+    newSecondaries.reserve(wave);
+    clock.reset();
+    for (size_t w = 0; w < waves; w++)
+    {
+        for (size_t i = 0; i < wave; i++)
+        {
+            newPrimaries.emplace_back(new MachineGun);
+            newSecondaries.emplace_back(new Pistol);
+        }
+        for (size_t i = 0; i < wave; i++)
+            checksum += uint64_t(newPrimaries[i]->name()[0]) + uint64_t(newSecondaries[i]->name()[0]);
+        newPrimaries.clear();
+        newSecondaries.clear();
+    }
+    double heapSeconds = clock.seconds();
+
+    //Whole waves at once
+    clock.reset();
+    for (size_t w = 0; w < waves; w++)
+    {
+        unique_ptr<KitBatch> batch = factory.makeKits(wave);
+        for (size_t i = 0; i < batch->size(); i++)
+            checksum += uint64_t(batch->primary(i).name()[0]) + uint64_t(batch->secondary(i).name()[0]);
+    }
+    double batchSeconds = clock.seconds();
+
+    double kits = double(wave * waves);
+    cout<<endl<<waves<<" waves of "<<wave<<" kits (checksum "<<checksum<<"):"<<endl;
+    cout<<"  new/delete per weapon:  "<<heapSeconds * 1e9 / kits<<" ns/kit"<<endl;
+    cout<<"  pooled per weapon:      "<<perKitSeconds * 1e9 / kits<<" ns/kit"<<endl;
+    cout<<"  makeKits batch:         "<<batchSeconds * 1e9 / kits<<" ns/kit"<<endl;
+}
+
 #endif //LAB_2_ABSTRACTFACTORY_H
@@ -0,0 +1,46 @@
+#ifndef LAB_2_BENCH_H
+#define LAB_2_BENCH_H
+
+#include <chrono>
+
+
+class Stopwatch{
+private:
+    chrono::steady_clock::time_point start;
+public:
+    Stopwatch()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        start = chrono::steady_clock::now();
+    }
+
+    double seconds() const
+    {
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+};
+
+
+//Silences cout while in scope, so factories that announce every call can be run in bulk
+class MuteCout{
+private:
+    streambuf* saved;
+public:
+    MuteCout()
+    {
+        saved = cout.rdbuf(nullptr);
+    }
+
+    MuteCout(const MuteCout&) = delete;
+
+    ~MuteCout()
+    {
+        cout.rdbuf(saved);
+    }
+};
+
+#endif //LAB_2_BENCH_H
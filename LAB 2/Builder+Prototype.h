@@ -3,146 +3,179 @@
 #ifndef LAB_2_BUILDER_PROTOTYPE_H
 #define LAB_2_BUILDER_PROTOTYPE_H
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "Bench.h"
 #include "CraftableWeapon.h"
 
+//The attach calls intern the part name and hand the ID to the one virtual attach(),
+//so a builder call neither allocates nor copies a string
 class GunBuilder{
+protected:
+    virtual GunBuilder& attach(Part part, AttachmentId id) = 0;
+
 public:
 
-    virtual GunBuilder& attachReceiver(string s) = 0;
-    virtual GunBuilder& attachBarrel(string s) = 0;
-    virtual GunBuilder& attachHandguard(string s) = 0;
-    virtual GunBuilder& attachBipod(string s) = 0;
-    virtual GunBuilder& attachStock(string s) = 0;
-    virtual GunBuilder& attachGrip(string s) = 0;
-    virtual GunBuilder& attachMagazine(string s) = 0;
+    GunBuilder& attachReceiver(const char* s) { return attach(RECEIVER, attachmentId(s)); }
+    GunBuilder& attachBarrel(const char* s) { return attach(BARREL, attachmentId(s)); }
+    GunBuilder& attachHandguard(const char* s) { return attach(HANDGUARD, attachmentId(s)); }
+    GunBuilder& attachBipod(const char* s) { return attach(BIPOD, attachmentId(s)); }
+    GunBuilder& attachStock(const char* s) { return attach(STOCK, attachmentId(s)); }
+    GunBuilder& attachGrip(const char* s) { return attach(GRIP, attachmentId(s)); }
+    GunBuilder& attachMagazine(const char* s) { return attach(MAGAZINE, attachmentId(s)); }
+    //For callers that interned the name already
+    GunBuilder& attachPart(Part part, AttachmentId id) { return attach(part, id); }
+    //Valid while the builder lives and until it next changes a part
     virtual CraftableWeapon* getResult() = 0;
+    //Shares the weapon with this builder until either of them changes a part
     virtual GunBuilder* clone() = 0;
+    //Copies the weapon right away, as clone used to
+    virtual GunBuilder* cloneDeep() = 0;
+    virtual ~GunBuilder() = default;
 
 };
 
+//Builders keep their weapon copy-on-write: clones share it, and the first attach that
+//actually changes a part gives the changing builder its own copy.
+//One builder is used by one thread at a time, but builders sharing a weapon may be on different
+//threads. use_count() is only a relaxed load, so when it says the weapon is ours alone an acquire
+//fence pairs it with the release in the last other owner's destructor; that owner's reads of the
+//weapon then happen before our writes.
 class ARBuilder : public GunBuilder{
 private:
 
 
-    AssaultRifle* rifle = new AssaultRifle;
+    shared_ptr<AssaultRifle> rifle;
     void Reset()
     {
-        rifle = new AssaultRifle;
+        rifle = make_shared<AssaultRifle>();
     }
 
-
-    ARBuilder(ARBuilder &other)
+    static AttachmentId* partOf(AssaultRifle& r, Part part)
     {
-        rifle = new AssaultRifle(*other.rifle);
-    }
-public:
-    ARBuilder(){
-        Reset();
+        switch (part)
+        {
+            case RECEIVER: return &r.receiver;
+            case BARREL: return &r.barrel;
+            case HANDGUARD: return &r.handguard;
+            case BIPOD: return &r.bipod;
+            case STOCK: return &r.stock;
+            case GRIP: return &r.grip;
+            case MAGAZINE: return &r.magazine;
+            default: return nullptr;
+        }
     }
-    GunBuilder& attachBarrel(string s) override
-    {
-        rifle->barrel = s;
-        return *this;
-    }
-    GunBuilder& attachBipod(string s) override
-    {
-        rifle->bipod = s;
-        return *this;
-    }
-    GunBuilder& attachGrip(string s) override
-    {
-        rifle->grip = s;
-        return *this;
-    }
-    GunBuilder& attachHandguard(string s) override
+
+    ARBuilder(ARBuilder &other, bool deep)
     {
-        rifle->handguard = s;
-        return *this;
+        rifle = deep ? make_shared<AssaultRifle>(*other.rifle) : other.rifle;
     }
-    GunBuilder& attachMagazine(string s) override
+protected:
+    GunBuilder& attach(Part part, AttachmentId id) override
     {
-        rifle->magazine = s;
+        AttachmentId* slot = partOf(*rifle, part);
+        if (slot == nullptr || *slot == id)
+            return *this;
+        if (rifle.use_count() > 1)
+        {
+            rifle = make_shared<AssaultRifle>(*rifle);
+            slot = partOf(*rifle, part);
+        }
+        else
+            atomic_thread_fence(memory_order_acquire);
+        *slot = id;
         return *this;
     }
-    GunBuilder& attachReceiver(string s) override
-    {
-        rifle->receiver = s;
-        return *this;
+public:
+    //The type getResult() really points to
+    typedef AssaultRifle Weapon;
+
+    ARBuilder(){
+        Reset();
     }
-    GunBuilder& attachStock(string s) override
+
+    CraftableWeapon* getResult() override
     {
-        rifle->stock = s;
-        return *this;
+        return rifle.get();
     }
 
-    CraftableWeapon* getResult()
+    GunBuilder* clone() override
     {
-        return rifle;
+        return new ARBuilder(*this, false);
     }
 
-    GunBuilder* clone() override
+    GunBuilder* cloneDeep() override
     {
-        return new ARBuilder(*this);
+        return new ARBuilder(*this, true);
     }
 };
 
 class HandgunBuilder: public GunBuilder{
 private:
-    Handgun* handgun;
+    shared_ptr<Handgun> handgun;
 
     void Reset()
     {
-        handgun = new Handgun;
-    }
-    HandgunBuilder(HandgunBuilder &other)
-    {
-        handgun = new Handgun(*other.handgun);
+        handgun = make_shared<Handgun>();
     }
-public:
 
-    HandgunBuilder(){
-        Reset();
-    }
-    GunBuilder& attachBarrel(string s) override
+    //A handgun has no handguard, bipod or stock
+    static AttachmentId* partOf(Handgun& h, Part part)
     {
-        handgun->barrel = s;
-        return *this;
+        switch (part)
+        {
+            case RECEIVER: return &h.receiver;
+            case BARREL: return &h.barrel;
+            case GRIP: return &h.grip;
+            case MAGAZINE: return &h.magazine;
+            default: return nullptr;
+        }
     }
-    GunBuilder& attachBipod(string s) override
-    {
-        return *this;
-    }
-    GunBuilder& attachGrip(string s) override
-    {
-        handgun->grip = s;
-        return *this;
-    }
-    GunBuilder& attachHandguard(string s) override
+
+    HandgunBuilder(HandgunBuilder &other, bool deep)
     {
-        return *this;
+        handgun = deep ? make_shared<Handgun>(*other.handgun) : other.handgun;
     }
-    GunBuilder& attachMagazine(string s) override
+protected:
+    GunBuilder& attach(Part part, AttachmentId id) override
     {
-        handgun->magazine = s;
+        AttachmentId* slot = partOf(*handgun, part);
+        if (slot == nullptr || *slot == id)
+            return *this;
+        if (handgun.use_count() > 1)
+        {
+            handgun = make_shared<Handgun>(*handgun);
+            slot = partOf(*handgun, part);
+        }
+        else
+            atomic_thread_fence(memory_order_acquire);
+        *slot = id;
         return *this;
     }
-    GunBuilder& attachReceiver(string s) override
-    {
-        handgun->receiver = s;
-        return *this;
+public:
+    typedef Handgun Weapon;
+
+    HandgunBuilder(){
+        Reset();
     }
-    GunBuilder& attachStock(string s) override
+
+    CraftableWeapon* getResult() override
     {
-        return *this;
+        return handgun.get();
     }
 
-    CraftableWeapon* getResult(){
-        return handgun;
+    GunBuilder* clone() override
+    {
+        return new HandgunBuilder(*this, false);
     }
 
-    GunBuilder* clone() override
+    GunBuilder* cloneDeep() override
     {
-        return new HandgunBuilder(*this);
+        return new HandgunBuilder(*this, true);
     }
 
 };
@@ -164,6 +197,142 @@ public:
         return builder->getResult();
 
     }
+
+    CraftableWeapon* constructSniper(GunBuilder* builder)
+    {
+        constructWeapon(builder);
+        builder->attachBarrel("Long Barrel")
+        .attachBipod("Bipod")
+        .attachStock("Precision Stock")
+        .attachMagazine("10-round Magazine");
+        return builder->getResult();
+    }
+
+    CraftableWeapon* constructCqb(GunBuilder* builder)
+    {
+        constructWeapon(builder);
+        builder->attachBarrel("Short Barrel")
+        .attachHandguard("Rail Handguard")
+        .attachStock("Collapsible Stock")
+        .attachMagazine("40-round Magazine");
+        return builder->getResult();
+    }
+};
+
+
+//Built presets by name. New weapons are cloned from the cached builder instead of replaying
+//the Director, and clones share the preset's parts until they change one.
+//The registry has a fixed capacity and only grows: names go into an open-addressing table of
+//atomic slots and builders into an array of atomic pointers, so finding and cloning a preset
+//take no lock and copy nothing, and any number of threads can clone while presets are added.
+//Adding locks. A replaced builder is kept until the registry goes away, since a clone may be
+//reading it; preset builders are never changed after add().
+class PresetRegistry{
+private:
+    struct Preset{
+        string name;
+        atomic<GunBuilder*> builder{nullptr};
+    };
+
+    size_t capacity;
+    unique_ptr<Preset[]> presets;
+    //A slot packs the name's hash (high half) and its preset number + 1 (low half); 0 is empty
+    unique_ptr<atomic<uint64_t>[]> slots;
+    size_t slotMask;
+    atomic<size_t> count{0};
+    vector<unique_ptr<GunBuilder>> owned;
+    mutex writeLock;
+
+    static uint32_t hashOf(const string& s)
+    {
+        uint32_t h = 2166136261u;
+        for (char c : s)
+            h = (h ^ uint8_t(c)) * 16777619u;
+        return h;
+    }
+
+    //Slot index holding the name, or the empty slot where it belongs; slot gets the value read
+    size_t probe(const string& name, uint32_t hash, uint64_t& slot) const
+    {
+        for (size_t i = hash & slotMask;; i = (i + 1) & slotMask)
+        {
+            slot = slots[i].load(memory_order_acquire);
+            if (slot == 0 || (uint32_t(slot >> 32) == hash && presets[uint32_t(slot) - 1].name == name))
+                return i;
+        }
+    }
+
+public:
+    explicit PresetRegistry(size_t maxPresets = 256)
+    {
+        capacity = maxPresets;
+        presets.reset(new Preset[capacity]);
+        size_t slotCount = 16;
+        while (slotCount < 2 * capacity)
+            slotCount *= 2;
+        slots.reset(new atomic<uint64_t>[slotCount]);
+        for (size_t i = 0; i < slotCount; i++)
+            slots[i].store(0, memory_order_relaxed);
+        slotMask = slotCount - 1;
+    }
+
+    PresetRegistry(const PresetRegistry&) = delete;
+
+    //Takes ownership of a built builder; replaces a preset of the same name.
+    //Throws length_error when the registry is full.
+    size_t add(const string& name, GunBuilder* built)
+    {
+        lock_guard<mutex> guard(writeLock);
+        owned.emplace_back(built);
+        uint32_t hash = hashOf(name);
+        uint64_t slot;
+        size_t i = probe(name, hash, slot);
+        if (slot != 0)
+        {
+            size_t id = uint32_t(slot) - 1;
+            presets[id].builder.store(built, memory_order_release);
+            return id;
+        }
+
+        size_t id = count.load(memory_order_relaxed);
+        if (id == capacity)
+        {
+            owned.pop_back();
+            throw length_error("PresetRegistry: more than " + to_string(capacity) + " presets");
+        }
+        presets[id].name = name;
+        presets[id].builder.store(built, memory_order_release);
+        slots[i].store(uint64_t(hash) << 32 | uint64_t(id + 1), memory_order_release);
+        count.store(id + 1, memory_order_release);
+        return id;
+    }
+
+    //Preset number for a name, or -1
+    int64_t find(const string& name) const
+    {
+        uint64_t slot;
+        probe(name, hashOf(name), slot);
+        return slot == 0 ? -1 : int64_t(uint32_t(slot) - 1);
+    }
+
+    //A new builder holding the preset weapon, or null if there is no such preset
+    GunBuilder* clone(size_t preset) const
+    {
+        if (preset >= count.load(memory_order_acquire))
+            return nullptr;
+        return presets[preset].builder.load(memory_order_acquire)->clone();
+    }
+
+    GunBuilder* clone(const string& name) const
+    {
+        int64_t preset = find(name);
+        return preset < 0 ? nullptr : clone(size_t(preset));
+    }
+
+    size_t size() const
+    {
+        return count.load(memory_order_acquire);
+    }
 };
 
 
@@ -175,7 +344,7 @@ void BuilderPrototypeDemo()
     Director director;
     director.constructWeapon(&ARbuilder);
     director.constructWeapon(&Hbuilder);
-    GunBuilder* ARbuilder2 = ARbuilder.clone();
+    unique_ptr<GunBuilder> ARbuilder2(ARbuilder.clone());
 
     ARbuilder2->attachMagazine("40-round Magazine")
     .attachHandguard("Rail Handguard")
@@ -190,7 +359,7 @@ void BuilderPrototypeDemo()
     cout<<endl;
 
 
-    GunBuilder* Hbuilder2 = Hbuilder.clone();
+    unique_ptr<GunBuilder> Hbuilder2(Hbuilder.clone());
 
     Hbuilder2->attachMagazine("21-round Magazine")
     .attachGrip("Ergonomic Pistol Grip");
@@ -207,4 +376,133 @@ void BuilderPrototypeDemo()
 
 
 
+void AttachmentIdDemo()
+{
+    cout<<"AssaultRifle: "<<sizeof(AssaultRifle)<<" bytes (was "<<sizeof(void*) + 7 * sizeof(string)
+        <<" with string parts), Handgun: "<<sizeof(Handgun)<<" bytes (was "<<sizeof(void*) + 4 * sizeof(string)<<")"<<endl;
+
+    //Same stock build over and over, as a crafting menu would
+    ARBuilder builder;
+    Director director;
+    const size_t builds = 1000000;
+    Stopwatch clock;
+    for (size_t i = 0; i < builds; i++)
+        director.constructWeapon(&builder);
+    double seconds = clock.seconds();
+
+    cout<<builds<<" Director builds: "<<seconds * 1e9 / builds<<" ns/build, "
+        <<AttachmentDictionary::global().size()<<" attachment names interned"<<endl;
+}
+
+//Thousands of variants of one stock rifle, each clone given one different part
+void CowCloneDemo()
+{
+    ARBuilder base;
+    Director director;
+    director.constructWeapon(&base);
+    //None of these is the stock magazine, so every "+ 1 part" variant really copies its parts
+    AttachmentId magazines[4] = {attachmentId("10-round Magazine"), attachmentId("40-round Magazine"),
+                                 attachmentId("Drum Magazine"), attachmentId("Extended Magazine")};
+
+    const size_t variants = 100000;
+    vector<unique_ptr<GunBuilder>> kept;
+    kept.reserve(variants);
+
+    Stopwatch clock;
+    for (size_t i = 0; i < variants; i++)
+    {
+        kept.emplace_back(base.cloneDeep());
+        kept.back()->attachPart(MAGAZINE, magazines[i % 4]);
+    }
+    double deepSeconds = clock.seconds();
+    kept.clear();
+
+    clock.reset();
+    for (size_t i = 0; i < variants; i++)
+    {
+        kept.emplace_back(base.clone());
+        kept.back()->attachPart(MAGAZINE, magazines[i % 4]);
+    }
+    double cowSeconds = clock.seconds();
+    kept.clear();
+
+    clock.reset();
+    for (size_t i = 0; i < variants; i++)
+        kept.emplace_back(base.clone());
+    double shareSeconds = clock.seconds();
+    kept.clear();
+
+    cout<<variants<<" variants of the stock rifle:"<<endl;
+    cout<<"  deep copy + 1 part:      "<<deepSeconds * 1e9 / variants<<" ns/variant"<<endl;
+    cout<<"  copy-on-write + 1 part:  "<<cowSeconds * 1e9 / variants<<" ns/variant"<<endl;
+    cout<<"  copy-on-write, no part:  "<<shareSeconds * 1e9 / variants<<" ns/variant"<<endl;
+}
+
+void PresetRegistryDemo()
+{
+    Director director;
+    PresetRegistry registry;
+    GunBuilder* stockRifle = new ARBuilder();
+    director.constructWeapon(stockRifle);
+    registry.add("stock rifle", stockRifle);
+    GunBuilder* stockHandgun = new HandgunBuilder();
+    director.constructWeapon(stockHandgun);
+    registry.add("stock handgun", stockHandgun);
+    GunBuilder* sniper = new ARBuilder();
+    director.constructSniper(sniper);
+    size_t sniperPreset = registry.add("sniper", sniper);
+    GunBuilder* cqb = new ARBuilder();
+    director.constructCqb(cqb);
+    registry.add("cqb", cqb);
+
+    unique_ptr<GunBuilder> mine(registry.clone("sniper"));
+    mine->attachGrip("Ergonomic Pistol Grip");
+    cout<<"Sniper preset, own grip:"<<endl;
+    mine->getResult()->show();
+    cout<<endl;
+
+    const size_t builds = 1000000;
+    Stopwatch clock;
+    for (size_t i = 0; i < builds; i++)
+    {
+        ARBuilder builder;
+        director.constructSniper(&builder);
+    }
+    double directorSeconds = clock.seconds();
+
+    clock.reset();
+    for (size_t i = 0; i < builds; i++)
+        unique_ptr<GunBuilder> builder(registry.clone(sniperPreset));
+    double cloneSeconds = clock.seconds();
+
+    //Several threads cloning and customizing the same presets
+    const size_t threadCount = 4;
+    const size_t presets = registry.size();
+    atomic<size_t> customized{0};
+    vector<thread> threads;
+    clock.reset();
+    for (size_t t = 0; t < threadCount; t++)
+        threads.emplace_back([&, t]
+        {
+            AttachmentId grip = attachmentId(t % 2 ? "Ergonomic Pistol Grip" : "Stock Pistol Grip");
+            size_t changed = 0;
+            for (size_t i = 0; i < builds / threadCount; i++)
+            {
+                unique_ptr<GunBuilder> builder(registry.clone(i % presets));
+                builder->attachPart(GRIP, grip);
+                changed += builder->getResult() != nullptr;
+            }
+            customized += changed;
+        });
+    for (auto& t : threads)
+        t.join();
+    double concurrentSeconds = clock.seconds();
+
+    cout<<presets<<" presets"<<endl;
+    cout<<"Director::constructSniper: "<<directorSeconds * 1e9 / builds<<" ns/weapon"<<endl;
+    cout<<"Registry clone:            "<<cloneSeconds * 1e9 / builds<<" ns/weapon"<<endl;
+    cout<<threadCount<<" threads cloned and customized "<<customized.load()<<" weapons in "
+        <<concurrentSeconds * 1000<<" ms"<<endl;
+}
+
 #endif //LAB_2_BUILDER_PROTOTYPE_H
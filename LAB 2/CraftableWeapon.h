@@ -2,31 +2,209 @@
 #ifndef LAB_2_CRAFTABLEWEAPON_H
 #define LAB_2_CRAFTABLEWEAPON_H
 
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+
+typedef uint16_t AttachmentId;
+
+enum Part{
+    RECEIVER,
+    BARREL,
+    HANDGUARD,
+    BIPOD,
+    STOCK,
+    GRIP,
+    MAGAZINE,
+    PART_COUNT
+};
+
+
+//Every attachment name in the game, interned to a 16-bit ID. Looking up a known name hashes
+//it and compares in place, so it allocates nothing; only a new name is copied in.
+//ID 0 is the empty name, which is also what an unattached part holds.
+//Thread-safe: lookups read an open-addressing table through atomics and take no lock; adding a
+//name locks. A full table is replaced by a bigger one and the old one kept for readers still
+//in it. Once all 65536 IDs are taken, interning a new name throws length_error.
+class AttachmentDictionary{
+private:
+    static const size_t MAX_NAMES = size_t(UINT16_MAX) + 1;
+
+    //A slot packs the name's hash (high half) and its ID + 1 (low half); 0 is empty
+    struct Table{
+        vector<atomic<uint64_t>> slots;
+
+        explicit Table(size_t size) : slots(size)
+        {
+        }
+    };
+
+    vector<unique_ptr<Table>> tables;
+    atomic<Table*> current{nullptr};
+    unique_ptr<atomic<const char*>[]> names;
+    vector<unique_ptr<char[]>> storage;
+    atomic<size_t> count{0};
+    mutex writeLock;
+
+    static uint32_t hashOf(const char* s)
+    {
+        uint32_t h = 2166136261u;
+        for (; *s; s++)
+            h = (h ^ uint8_t(*s)) * 16777619u;
+        return h;
+    }
+
+    //Slot index holding the name, or the empty slot where it belongs. slot gets the value that
+    //was matched (0 for empty); the slot itself may be filled by a writer right after.
+    size_t find(const Table& table, const char* name, uint32_t hash, uint64_t& slot) const
+    {
+        size_t mask = table.slots.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask)
+        {
+            slot = table.slots[i].load(memory_order_acquire);
+            if (slot == 0)
+                return i;
+            if (uint32_t(slot >> 32) == hash
+                && strcmp(names[uint32_t(slot) - 1].load(memory_order_acquire), name) == 0)
+                return i;
+        }
+    }
+
+    void grow()
+    {
+        Table& old = *current.load(memory_order_relaxed);
+        tables.emplace_back(new Table(old.slots.size() * 2));
+        Table& bigger = *tables.back();
+        for (auto& s : old.slots)
+        {
+            uint64_t slot = s.load(memory_order_relaxed);
+            if (slot == 0)
+                continue;
+            size_t mask = bigger.slots.size() - 1;
+            size_t i = size_t(slot >> 32) & mask;
+            while (bigger.slots[i].load(memory_order_relaxed) != 0)
+                i = (i + 1) & mask;
+            bigger.slots[i].store(slot, memory_order_relaxed);
+        }
+        current.store(&bigger, memory_order_release);
+    }
+
+    AttachmentDictionary() : names(new atomic<const char*>[MAX_NAMES])
+    {
+        tables.emplace_back(new Table(64));
+        current.store(tables.back().get());
+        intern("");
+    }
+
+public:
+    AttachmentDictionary(const AttachmentDictionary&) = delete;
+
+    static AttachmentDictionary& global()
+    {
+        static AttachmentDictionary dictionary;
+        return dictionary;
+    }
+
+    AttachmentId intern(const char* name)
+    {
+        uint32_t hash = hashOf(name);
+        {
+            const Table& table = *current.load(memory_order_acquire);
+            uint64_t slot;
+            find(table, name, hash, slot);
+            if (slot != 0)
+                return AttachmentId(uint32_t(slot) - 1);
+        }
+
+        lock_guard<mutex> guard(writeLock);
+        Table& table = *current.load(memory_order_relaxed);
+        uint64_t slot;
+        size_t i = find(table, name, hash, slot);
+        if (slot != 0)
+            return AttachmentId(uint32_t(slot) - 1);
+        size_t id = count.load(memory_order_relaxed);
+        if (id == MAX_NAMES)
+            throw length_error(string("AttachmentDictionary: no ID left for \"") + name + "\"");
+
+        size_t length = strlen(name);
+        storage.emplace_back(new char[length + 1]);
+        memcpy(storage.back().get(), name, length + 1);
+        names[id].store(storage.back().get(), memory_order_release);
+        table.slots[i].store(uint64_t(hash) << 32 | uint64_t(id + 1), memory_order_release);
+        count.store(id + 1, memory_order_release);
+        if ((id + 1) * 2 > table.slots.size())
+            grow();
+        return AttachmentId(id);
+    }
+
+    const char* name(AttachmentId id) const
+    {
+        return id < count.load(memory_order_acquire) ? names[id].load(memory_order_acquire) : "";
+    }
+
+    size_t size() const
+    {
+        return count.load();
+    }
+};
+
+AttachmentId attachmentId(const char* name)
+{
+    return AttachmentDictionary::global().intern(name);
+}
+
+const char* attachmentName(AttachmentId id)
+{
+    return AttachmentDictionary::global().name(id);
+}
+
+
 class CraftableWeapon{
 public:
     virtual void show() = 0;
+    virtual ~CraftableWeapon() = default;
 };
 
 
+//Parts are attachment IDs; names are looked up only when the weapon is shown
 class AssaultRifle : public CraftableWeapon{
 private:
-    string receiver;
-    string barrel;
-    string handguard;
-    string bipod;
-    string stock;
-    string grip;
-    string magazine;
+    AttachmentId receiver = 0;
+    AttachmentId barrel = 0;
+    AttachmentId handguard = 0;
+    AttachmentId bipod = 0;
+    AttachmentId stock = 0;
+    AttachmentId grip = 0;
+    AttachmentId magazine = 0;
 public:
+    AttachmentId part(Part p) const
+    {
+        switch (p)
+        {
+            case RECEIVER: return receiver;
+            case BARREL: return barrel;
+            case HANDGUARD: return handguard;
+            case BIPOD: return bipod;
+            case STOCK: return stock;
+            case GRIP: return grip;
+            case MAGAZINE: return magazine;
+            default: return 0;
+        }
+    }
+
     void show()
     {
-        cout<<receiver<<endl;
-        cout<<barrel<<endl;
-        cout<<handguard<<endl;
-        cout<<bipod<<endl;
-        cout<<stock<<endl;
-        cout<<grip<<endl;
-        cout<<magazine<<endl;
+        cout<<attachmentName(receiver)<<endl;
+        cout<<attachmentName(barrel)<<endl;
+        cout<<attachmentName(handguard)<<endl;
+        cout<<attachmentName(bipod)<<endl;
+        cout<<attachmentName(stock)<<endl;
+        cout<<attachmentName(grip)<<endl;
+        cout<<attachmentName(magazine)<<endl;
     }
     friend class ARBuilder;
 };
@@ -34,18 +212,30 @@ public:
 
 class Handgun : public CraftableWeapon{
 private:
-    string receiver;
-    string barrel;
-    string grip;
-    string magazine;
+    AttachmentId receiver = 0;
+    AttachmentId barrel = 0;
+    AttachmentId grip = 0;
+    AttachmentId magazine = 0;
 
 public:
+    AttachmentId part(Part p) const
+    {
+        switch (p)
+        {
+            case RECEIVER: return receiver;
+            case BARREL: return barrel;
+            case GRIP: return grip;
+            case MAGAZINE: return magazine;
+            default: return 0;
+        }
+    }
+
     void show()
     {
-        cout<<receiver<<endl;
-        cout<<barrel<<endl;
-        cout<<grip<<endl;
-        cout<<magazine<<endl;
+        cout<<attachmentName(receiver)<<endl;
+        cout<<attachmentName(barrel)<<endl;
+        cout<<attachmentName(grip)<<endl;
+        cout<<attachmentName(magazine)<<endl;
     }
     friend class HandgunBuilder;
 };
@@ -2,105 +2,335 @@
 #ifndef LAB_2_FACTORYMETHOD_H
 #define LAB_2_FACTORYMETHOD_H
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+#include "Bench.h"
+#include "LootTable.h"
+#include "Random.h"
+#include "WeaponCatalog.h"
+
 
 class Weapon{
 public:
     virtual void equipWeapon() = 0;
+    virtual ~Weapon() = default;
 };
 
 class Shotgun : public Weapon{
 private:
-    string name;
+    const WeaponModel* model;
 public:
-    Shotgun(string n)
-    {name = n;}
+    Shotgun(const WeaponModel* m)
+    {model = m;}
     void equipWeapon() override
     {
-        cout<<"Equipping Shotgun "<<name<<endl;
+        cout<<"Equipping Shotgun "<<model->name()<<endl;
     }
 };
 
 class Rifle : public Weapon{
 private:
-    string name;
+    const WeaponModel* model;
 public:
-    Rifle(string n)
-    {name = n;}
+    Rifle(const WeaponModel* m)
+    {model = m;}
     void equipWeapon() override
     {
-        cout<<"Equipping Rifle "<<name <<endl;
+        cout<<"Equipping Rifle "<<model->name() <<endl;
     }
 };
 
+//createWeapon hands out weapons owned by the factory; they stay valid as long as it does.
+//Which model drops is drawn from the factory's loot table: the catalog drop weights unless
+//the factory is given its own.
+//Once built, a factory is only read: draws use the calling thread's random stream, so one
+//factory can serve any number of threads. setDropWeights and setVerbose are not thread-safe.
+//A catalog may have no models of a class; that factory's createWeapon returns null.
 class WeaponFactory{
+protected:
+    const WeaponCatalog& catalog;
+    WeaponClass weaponClass;
+    AliasTable lootTable;
+    bool verbose = true;
+
+    WeaponFactory(const WeaponCatalog& models, WeaponClass c, const vector<double>& weights)
+        : catalog(models)
+    {
+        weaponClass = c;
+        setDropWeights(weights);
+    }
+
+    uint32_t roll() const
+    {
+        return lootTable.sample(threadRandom());
+    }
+
 public:
 
     virtual Weapon* createWeapon() = 0;
-    ~WeaponFactory() = default;
+    virtual ~WeaponFactory() = default;
+
+    //One weight per model of the factory's class, in catalog order; empty means the catalog weights.
+    //Throws invalid_argument for the wrong number of weights, a negative one, or all zero.
+    //Catalog weights get the same value checks from AliasTable::build; all zero there means equal.
+    void setDropWeights(const vector<double>& weights)
+    {
+        if (!weights.empty())
+        {
+            if (weights.size() != catalog.count(weaponClass))
+                throw invalid_argument("setDropWeights: " + to_string(weights.size()) + " weights for "
+                                       + to_string(catalog.count(weaponClass)) + " " + weaponClassName(weaponClass) + " models");
+            double total = 0;
+            for (double w : weights)
+            {
+                if (!(w >= 0) || std::isinf(w))
+                    throw invalid_argument("setDropWeights: weights must be finite and not negative");
+                total += w;
+            }
+            if (total <= 0)
+                throw invalid_argument("setDropWeights: all weights are zero");
+            lootTable.build(weights);
+            return;
+        }
+        vector<double> defaults;
+        for (size_t i = 0; i < catalog.count(weaponClass); i++)
+            defaults.push_back(catalog.models(weaponClass)[i].dropWeight);
+        lootTable.build(defaults);
+    }
+
+    //Whether createWeapon announces itself on cout
+    void setVerbose(bool v)
+    {
+        verbose = v;
+    }
+
+    //n drops for loot simulations, as indices into catalog.models(weaponClass)
+    void rollDrops(size_t n, vector<uint32_t>& drops) const
+    {
+        drops.resize(lootTable.size() == 0 ? 0 : n);
+        lootTable.sample(threadRandom(), drops.data(), drops.size());
+    }
 };
 
 
+//Weapons hold nothing but their catalog entry, so one instance per model is shared by every
+//caller. All instances are made up front in one array, so createWeapon neither allocates
+//nor writes anything shared.
 class ShotgunFactory : public WeaponFactory{
 private:
-    vector<Shotgun*> shotguns;
+    vector<Shotgun> shotguns;
 public:
-    void Reset()
+    ShotgunFactory(const WeaponCatalog& models = WeaponCatalog::standard(), const vector<double>& weights = {})
+        : WeaponFactory(models, SHOTGUN, weights)
     {
-        shotguns = {new Shotgun("Benelli M4 Super 90"),
-                    new Shotgun("Remington 870"),
-                    new Shotgun("Mossberg 500")
-        };
-
+        shotguns.reserve(catalog.count(SHOTGUN));
+        for (size_t i = 0; i < catalog.count(SHOTGUN); i++)
+            shotguns.emplace_back(catalog.models(SHOTGUN) + i);
     }
-    ShotgunFactory()
+    Weapon* createWeapon() override
     {
-        Reset();
+        if (verbose)
+            cout<<"Selecting Shotgun, adding shotgun ammo"<<endl;
+        return shotguns.empty() ? nullptr : &shotguns[roll()];
     }
-    Weapon* createWeapon() override
+    size_t instances() const
     {
-        cout<<"Selecting Shotgun, adding shotgun ammo"<<endl;
-        Shotgun *shotgun = shotguns[rand() % shotguns.size()];
-        Reset();
-        return shotgun;
+        return shotguns.size();
     }
 };
 
 class RifleFactory : public WeaponFactory{
 private:
-    vector<Rifle*> rifles;
+    vector<Rifle> rifles;
 
 public:
 
-    void Reset()
+    RifleFactory(const WeaponCatalog& models = WeaponCatalog::standard(), const vector<double>& weights = {})
+        : WeaponFactory(models, RIFLE, weights)
     {
-        rifles= {new Rifle("M4A1"),
-                 new Rifle("MK17"),
-                 new Rifle("MK18")
-        };
+        rifles.reserve(catalog.count(RIFLE));
+        for (size_t i = 0; i < catalog.count(RIFLE); i++)
+            rifles.emplace_back(catalog.models(RIFLE) + i);
     }
 
-    RifleFactory()
+    Weapon* createWeapon() override
     {
-        Reset();
+        if (verbose)
+            cout<<"Selecting Rifle, adding rifle ammo"<<endl;
+        return rifles.empty() ? nullptr : &rifles[roll()];
     }
-
-    Weapon* createWeapon() override
+    size_t instances() const
     {
-        cout<<"Selecting Rifle, adding rifle ammo"<<endl;
-        Rifle *rifle = rifles[rand() % rifles.size()];
-        Reset();
-        return rifle;
+        return rifles.size();
     }
 };
 
 void FactoryMethodDemo(){
 
 
-    vector<WeaponFactory*> factories = { new ShotgunFactory, new RifleFactory };
+    vector<unique_ptr<WeaponFactory>> factories;
+    factories.emplace_back(new ShotgunFactory);
+    factories.emplace_back(new RifleFactory);
+
+    Weapon* weapon = factories[randomBelow(uint32_t(factories.size()))]->createWeapon();
+    if (weapon != nullptr)
+        weapon->equipWeapon();
+
+}
+
+
+void WeaponCatalogDemo()
+{
+    ShotgunFactory shotguns;
+    RifleFactory rifles;
+    const size_t calls = 1000000;
+
+    Stopwatch clock;
+    {
+        MuteCout mute;
+        for (size_t i = 0; i < calls; i++)
+        {
+            Weapon* shotgun = shotguns.createWeapon();
+            if (shotgun != nullptr)
+                shotgun->equipWeapon();
+            Weapon* rifle = rifles.createWeapon();
+            if (rifle != nullptr)
+                rifle->equipWeapon();
+        }
+    }
+    double seconds = clock.seconds();
+
+    cout<<2 * calls<<" weapons created in "<<seconds * 1000<<" ms from "
+        <<shotguns.instances() + rifles.instances()<<" shared instances"<<endl;
+}
+
+void LootTableDemo()
+{
+    RifleFactory rifles(WeaponCatalog::builtin());
+    const WeaponModel* models = WeaponCatalog::builtin().models(RIFLE);
+    size_t count = WeaponCatalog::builtin().count(RIFLE);
+
+    vector<uint32_t> drops;
+    rifles.rollDrops(1000000, drops);
+    vector<size_t> seen(count);
+    double totalWeight = 0;
+    for (uint32_t d : drops)
+        seen[d]++;
+    for (size_t i = 0; i < count; i++)
+        totalWeight += models[i].dropWeight;
+    for (size_t i = 0; i < count; i++)
+        cout<<models[i].name()<<": weight "<<models[i].dropWeight / totalWeight * 100<<"%, dropped "
+            <<seen[i] / 10000.0<<"%"<<endl;
+
+    //A big table costs the same per draw
+    const size_t items = 1000000;
+    vector<double> weights(items);
+    Xoshiro256 gen(7);
+    for (auto& w : weights)
+        w = double(gen() % 1000 + 1);
+    Stopwatch clock;
+    AliasTable table(weights);
+    double buildSeconds = clock.seconds();
+
+    const size_t batch = 10000000;
+    drops.resize(batch);
+    clock.reset();
+    table.sample(gen, drops.data(), batch);
+    double sampleSeconds = clock.seconds();
+
+    cout<<items<<"-item table built in "<<buildSeconds * 1000<<" ms, "
+        <<uint64_t(batch / sampleSeconds)<<" drops/s"<<endl;
+}
+
+//Where demos write their scratch files; the build passes its own directory
+#ifndef SCRATCH_DIR
+#define SCRATCH_DIR "."
+#endif
+
+//The standard catalog, then a 50k-model catalog file mapped and put to work
+void CatalogFileDemo()
+{
+    const WeaponCatalog& standard = WeaponCatalog::standard();
+    cout<<(standard.isMapped() ? "Mapped " WEAPON_CATALOG_FILE : "Built-in catalog")<<": "
+        <<standard.count(SHOTGUN)<<" shotguns, "<<standard.count(RIFLE)<<" rifles"<<endl;
 
-    Weapon* weapon = factories[rand() % factories.size()]->createWeapon();
-    weapon->equipWeapon();
+    const size_t models = 50000;
+    string path = string(SCRATCH_DIR) + "/weapons50k.wcat";
+    CatalogWriter::synthetic(models, 9).save(path);
 
+    string error;
+    Stopwatch clock;
+    unique_ptr<WeaponCatalog> catalog = WeaponCatalog::open(path, error);
+    double openSeconds = clock.seconds();
+    if (catalog == nullptr)
+    {
+        cout<<error<<endl;
+        return;
+    }
+
+    clock.reset();
+    ShotgunFactory shotguns(*catalog);
+    RifleFactory rifles(*catalog);
+    double factorySeconds = clock.seconds();
+
+    cout<<catalog->size()<<"-model catalog mapped in "<<openSeconds * 1000<<" ms, factories ready after "
+        <<factorySeconds * 1000<<" ms more"<<endl;
+    for (WeaponFactory* factory : {static_cast<WeaponFactory*>(&shotguns), static_cast<WeaponFactory*>(&rifles)})
+    {
+        Weapon* weapon = factory->createWeapon();
+        if (weapon != nullptr)
+            weapon->equipWeapon();
+    }
+    remove(path.c_str());
+}
+
+//createWeapon/s as threads are added, every thread sharing the same two factories
+void FactoryScalingDemo()
+{
+    ShotgunFactory shotguns;
+    RifleFactory rifles;
+    shotguns.setVerbose(false);
+    rifles.setVerbose(false);
+    const size_t callsPerThread = 200000;
+
+    cout<<"threads\tcreateWeapon/s"<<endl;
+    double best = 0;
+    vector<pair<size_t, double>> results;
+    for (size_t threadCount = 1; threadCount <= 64; threadCount *= 2)
+    {
+        atomic<uintptr_t> checksum{0};
+        vector<thread> threads;
+        Stopwatch clock;
+        for (size_t t = 0; t < threadCount; t++)
+            threads.emplace_back([&]
+            {
+                uintptr_t sum = 0;
+                for (size_t i = 0; i < callsPerThread; i++)
+                {
+                    WeaponFactory& factory = i % 2 ? static_cast<WeaponFactory&>(rifles) : shotguns;
+                    sum += reinterpret_cast<uintptr_t>(factory.createWeapon());
+                }
+                checksum += sum;
+            });
+        for (auto& t : threads)
+            t.join();
+        double rate = threadCount * callsPerThread / clock.seconds();
+        results.emplace_back(threadCount, rate);
+        best = max(best, rate);
+    }
+
+    for (auto& r : results)
+    {
+        cout<<r.first<<"\t"<<uint64_t(r.second)<<"\t";
+        cout<<string(size_t(40 * r.second / best), '#')<<endl;
+    }
+    cout<<"("<<thread::hardware_concurrency()<<" hardware threads)"<<endl;
 }
 
 #endif //LAB_2_FACTORYMETHOD_H
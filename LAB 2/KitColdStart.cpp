@@ -0,0 +1,97 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cerrno>
+#include <cstdio>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+#include "KitRegistry.h"
+
+//Cold start with many kit plugins on disk: copies one plugin N times into a scratch
+//directory, then times a lazy start (scan, then create one kit) against loading them all.
+//    KIT_COLDSTART [plugins]
+
+//The build passes its own directory
+#ifndef SCRATCH_DIR
+#define SCRATCH_DIR "."
+#endif
+
+bool copyFile(const string& from, const string& to)
+{
+    ifstream in(from, ios::binary);
+    ofstream out(to, ios::binary);
+    out<<in.rdbuf();
+    return bool(in) && bool(out);
+}
+
+int main(int argc, char** argv)
+{
+    size_t plugins = argc > 1 ? stoul(argv[1]) : 500;
+    string source = string(KIT_PLUGIN_DIR) + "/SniperKit" + KIT_PLUGIN_SUFFIX;
+
+    string dir = string(SCRATCH_DIR) + "/coldstart_kits";
+#ifdef _WIN32
+    int made = _mkdir(dir.c_str());
+#else
+    int made = mkdir(dir.c_str(), 0700);
+#endif
+    if (made != 0 && errno != EEXIST)
+    {
+        cout<<"Cannot create "<<dir<<endl;
+        return 1;
+    }
+    vector<string> files;
+    for (size_t i = 0; i < plugins; i++)
+    {
+        files.push_back(dir + "/Kit" + to_string(i) + KIT_PLUGIN_SUFFIX);
+        if (!copyFile(source, files.back()))
+        {
+            cout<<"Cannot copy "<<source<<endl;
+            return 1;
+        }
+    }
+
+    double lazyScan, lazyFirst, eagerSeconds;
+    size_t eagerLoaded;
+    {
+        KitRegistry registry;
+        Stopwatch clock;
+        registry.scan(dir);
+        lazyScan = clock.seconds();
+        unique_ptr<KitFactory> kit = registry.create("Kit" + to_string(plugins / 2));
+        lazyFirst = clock.seconds();
+        if (kit == nullptr)
+        {
+            cout<<registry.lastError()<<endl;
+            return 1;
+        }
+    }
+    {
+        KitRegistry registry;
+        Stopwatch clock;
+        registry.scan(dir);
+        eagerLoaded = registry.loadAll();
+        unique_ptr<KitFactory> kit = registry.create("Kit" + to_string(plugins / 2));
+        eagerSeconds = clock.seconds();
+    }
+
+    for (auto& file : files)
+        remove(file.c_str());
+#ifdef _WIN32
+    _rmdir(dir.c_str());
+#else
+    rmdir(dir.c_str());
+#endif
+
+    cout<<plugins<<" kit plugins on disk"<<endl;
+    cout<<"Lazy:  scan "<<lazyScan * 1000<<" ms, first kit ready after "<<lazyFirst * 1000<<" ms (1 plugin loaded)"<<endl;
+    cout<<"Eager: first kit ready after "<<eagerSeconds * 1000<<" ms ("<<eagerLoaded<<" plugins loaded)"<<endl;
+    return 0;
+}
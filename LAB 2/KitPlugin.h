@@ -0,0 +1,25 @@
+#ifndef LAB_2_KITPLUGIN_H
+#define LAB_2_KITPLUGIN_H
+
+#include "AbstractFactory.h"
+
+
+//What a kit plugin exports: one extern "C" function making its factory.
+//A plugin source defines its weapons and ends with KIT_PLUGIN(ItsKitFactory).
+typedef KitFactory* (*KitFactoryMaker)();
+
+#define KIT_PLUGIN_ENTRY "createKitFactory"
+
+#ifdef _WIN32
+#define KIT_PLUGIN_EXPORT __declspec(dllexport)
+#else
+#define KIT_PLUGIN_EXPORT
+#endif
+
+#define KIT_PLUGIN(Factory) \
+    extern "C" KIT_PLUGIN_EXPORT KitFactory* createKitFactory() \
+    { \
+        return new Factory(); \
+    }
+
+#endif //LAB_2_KITPLUGIN_H
@@ -0,0 +1,276 @@
+#ifndef LAB_2_KITREGISTRY_H
+#define LAB_2_KITREGISTRY_H
+
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <dlfcn.h>
+#endif
+
+#include "KitPlugin.h"
+
+//Where the build puts the kit plugins
+#ifndef KIT_PLUGIN_DIR
+#define KIT_PLUGIN_DIR "kits"
+#endif
+
+#ifdef _WIN32
+#define KIT_PLUGIN_SUFFIX ".dll"
+#else
+#define KIT_PLUGIN_SUFFIX ".so"
+#endif
+
+
+//Kit factories that live in shared objects, one kit per file, keyed by file name
+//(kits/SniperKit.so, or SniperKit.dll on Windows, is the kit "SniperKit"). scan() only lists the
+//files; a plugin is loaded the first time its kit is asked for, so startup pays for the kits actually used.
+//Lookups read an immutable table published through an atomic pointer and take no lock; only
+//scanning and the first load of each plugin lock. A loaded plugin is never unloaded: factories
+//and pooled weapons made by it use its code and statics, and may outlive the registry.
+class KitRegistry{
+private:
+    struct Entry{
+        string path;
+        atomic<KitFactoryMaker> make{nullptr};
+        void* library = nullptr;
+    };
+
+    typedef unordered_map<string, Entry*> Table;
+
+    deque<Entry> entries;
+    vector<unique_ptr<Table>> tables;
+    atomic<const Table*> current{nullptr};
+    atomic<size_t> loadedCount{0};
+    mutable mutex writeLock;
+    string error;
+
+    Entry* lookup(const string& kit) const
+    {
+        const Table* table = current.load(memory_order_acquire);
+        if (table == nullptr)
+            return nullptr;
+        auto found = table->find(kit);
+        return found == table->end() ? nullptr : found->second;
+    }
+
+    KitFactoryMaker load(Entry& entry)
+    {
+        lock_guard<mutex> guard(writeLock);
+        return loadLocked(entry);
+    }
+
+    //The platform's shared library calls: dlopen on POSIX, LoadLibrary on Windows
+    static void* openLibrary(const string& path, string& why)
+    {
+#ifdef _WIN32
+        HMODULE library = LoadLibraryA(path.c_str());
+        if (library == nullptr)
+            why = "cannot load " + path + " (error " + to_string(GetLastError()) + ")";
+        return reinterpret_cast<void*>(library);
+#else
+        void* library = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (library == nullptr)
+            why = dlerror();
+        return library;
+#endif
+    }
+
+    static KitFactoryMaker findMaker(void* library)
+    {
+#ifdef _WIN32
+        return reinterpret_cast<KitFactoryMaker>(GetProcAddress(static_cast<HMODULE>(library), KIT_PLUGIN_ENTRY));
+#else
+        return reinterpret_cast<KitFactoryMaker>(dlsym(library, KIT_PLUGIN_ENTRY));
+#endif
+    }
+
+    static void closeLibrary(void* library)
+    {
+#ifdef _WIN32
+        FreeLibrary(static_cast<HMODULE>(library));
+#else
+        dlclose(library);
+#endif
+    }
+
+    //File names in the directory that end in KIT_PLUGIN_SUFFIX; false if it cannot be read
+    static bool listPlugins(const string& directory, vector<string>& names)
+    {
+        const string suffix = KIT_PLUGIN_SUFFIX;
+#ifdef _WIN32
+        WIN32_FIND_DATAA file;
+        HANDLE find = FindFirstFileA((directory + "\\*" + suffix).c_str(), &file);
+        if (find == INVALID_HANDLE_VALUE)
+            return GetLastError() == ERROR_FILE_NOT_FOUND;
+        do
+        {
+            string name = file.cFileName;
+            if (name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0)
+                names.push_back(name);
+        }
+        while (FindNextFileA(find, &file));
+        FindClose(find);
+#else
+        DIR* dir = opendir(directory.c_str());
+        if (dir == nullptr)
+            return false;
+        while (dirent* file = readdir(dir))
+        {
+            string name = file->d_name;
+            if (name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0)
+                names.push_back(name);
+        }
+        closedir(dir);
+#endif
+        return true;
+    }
+
+    KitFactoryMaker loadLocked(Entry& entry)
+    {
+        KitFactoryMaker make = entry.make.load(memory_order_acquire);
+        if (make != nullptr)
+            return make;
+
+        void* library = openLibrary(entry.path, error);
+        if (library == nullptr)
+            return nullptr;
+        make = findMaker(library);
+        if (make == nullptr)
+        {
+            error = entry.path + ": no " + KIT_PLUGIN_ENTRY;
+            closeLibrary(library);
+            return nullptr;
+        }
+        entry.library = library;
+        entry.make.store(make, memory_order_release);
+        loadedCount++;
+        return make;
+    }
+
+public:
+    KitRegistry() = default;
+    KitRegistry(const KitRegistry&) = delete;
+
+    //Adds every plugin file in the directory to the registry without loading it; returns how many were new
+    size_t scan(const string& directory)
+    {
+        lock_guard<mutex> guard(writeLock);
+        vector<string> names;
+        if (!listPlugins(directory, names))
+        {
+            error = "cannot open " + directory;
+            return 0;
+        }
+
+        const Table* old = current.load(memory_order_relaxed);
+        unique_ptr<Table> table(old != nullptr ? new Table(*old) : new Table());
+        size_t added = 0;
+        for (auto& name : names)
+        {
+            string kit = name.substr(0, name.size() - strlen(KIT_PLUGIN_SUFFIX));
+            if (table->count(kit))
+                continue;
+            entries.emplace_back();
+            entries.back().path = directory + "/" + name;
+            (*table)[kit] = &entries.back();
+            added++;
+        }
+
+        //Readers may still hold the old table, so it is kept until the registry goes away
+        current.store(table.get(), memory_order_release);
+        tables.push_back(move(table));
+        return added;
+    }
+
+    bool has(const string& kit) const
+    {
+        return lookup(kit) != nullptr;
+    }
+
+    //Null if the kit is unknown or its plugin fails to load (see lastError)
+    unique_ptr<KitFactory> create(const string& kit)
+    {
+        Entry* entry = lookup(kit);
+        if (entry == nullptr)
+            return nullptr;
+        KitFactoryMaker make = entry->make.load(memory_order_acquire);
+        if (make == nullptr)
+            make = load(*entry);
+        return unique_ptr<KitFactory>(make != nullptr ? make() : nullptr);
+    }
+
+    //Loads every plugin up front, which is what the registry avoids by default
+    size_t loadAll()
+    {
+        lock_guard<mutex> guard(writeLock);
+        size_t ok = 0;
+        for (auto& entry : entries)
+            if (loadLocked(entry) != nullptr)
+                ok++;
+        return ok;
+    }
+
+    vector<string> kits() const
+    {
+        vector<string> names;
+        const Table* table = current.load(memory_order_acquire);
+        if (table != nullptr)
+            for (auto& kit : *table)
+                names.push_back(kit.first);
+        return names;
+    }
+
+    size_t available() const
+    {
+        const Table* table = current.load(memory_order_acquire);
+        return table == nullptr ? 0 : table->size();
+    }
+
+    size_t loaded() const
+    {
+        return loadedCount.load();
+    }
+
+    string lastError() const
+    {
+        lock_guard<mutex> guard(writeLock);
+        return error;
+    }
+};
+
+
+void KitPluginDemo()
+{
+    KitRegistry registry;
+    registry.scan(KIT_PLUGIN_DIR);
+    cout<<registry.available()<<" kit plugins available, "<<registry.loaded()<<" loaded"<<endl;
+
+    for (const char* kit : {"SniperKit", "BreacherKit", "SniperKit", "NoSuchKit"})
+    {
+        unique_ptr<KitFactory> factory = registry.create(kit);
+        if (factory == nullptr)
+        {
+            cout<<kit<<": not available"<<endl;
+            continue;
+        }
+        PrimaryHandle primary = factory->makePrimary();
+        SecondaryHandle secondary = factory->makeSecondary();
+        cout<<kit<<": ";
+        primary->equipPrimary();
+        cout<<", ";
+        secondary->equipSecondary();
+        cout<<endl;
+    }
+    cout<<registry.loaded()<<" plugins loaded"<<endl;
+}
+
+#endif //LAB_2_KITREGISTRY_H
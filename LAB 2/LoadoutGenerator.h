@@ -0,0 +1,311 @@
+#ifndef LAB_2_LOADOUTGENERATOR_H
+#define LAB_2_LOADOUTGENERATOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+
+#include "Bench.h"
+#include "Builder+Prototype.h"
+
+
+//The attachments each part may take. A part with no options is left unattached,
+//so give none for the parts a weapon does not have.
+struct AttachmentOptions{
+    vector<AttachmentId> options[PART_COUNT];
+
+    AttachmentOptions& add(Part part, const char* name)
+    {
+        options[part].push_back(attachmentId(name));
+        return *this;
+    }
+
+    //"Prefix 1" to "Prefix count"
+    AttachmentOptions& addNumbered(Part part, const string& prefix, size_t count)
+    {
+        for (size_t i = 1; i <= count; i++)
+            add(part, (prefix + " " + to_string(i)).c_str());
+        return *this;
+    }
+
+    //Every combination, legal or not. Throws overflow_error past 2^64.
+    uint64_t combinations() const
+    {
+        uint64_t n = 1;
+        for (auto& o : options)
+        {
+            if (o.empty())
+                continue;
+            if (n > UINT64_MAX / o.size())
+                throw overflow_error("AttachmentOptions: more than 2^64 combinations");
+            n *= o.size();
+        }
+        return n;
+    }
+};
+
+
+struct LoadoutReport{
+    uint64_t combinations = 0;
+    uint64_t built = 0;
+    uint64_t rejected = 0;
+    size_t threads = 0;
+    double seconds = 0;
+    double buildsPerSecond = 0;
+};
+
+
+//Builds every legal combination of the options for one weapon type and streams the weapons to a
+//sink in batches, without ever holding them all.
+//Combination k is a mixed-radix number with one digit per part. Threads take chunks of consecutive
+//numbers from a shared counter, so a thread whose chunk is mostly illegal simply takes the next.
+//Inside a chunk the digits advance like an odometer and only the parts that changed are attached,
+//usually just the receiver.
+//Each thread has its own builder and a batch of weapons allocated once. A full batch is passed to
+//sink(batch, count, thread) and then reused, so memory stays at threads x batch size weapons.
+//The sink is called from every thread at once: keep its state per thread index or lock it.
+//legal(parts) sees the attachment IDs indexed by Part and decides whether to build. Every thread
+//calls the same rule object, so it must be safe to call concurrently; a stateless lambda is.
+//Builder::Weapon names the type getResult() builds, which is what the batches hold.
+template <class Builder>
+class LoadoutGenerator{
+public:
+    typedef typename Builder::Weapon Weapon;
+    static_assert(is_base_of<CraftableWeapon, Weapon>::value, "Builder::Weapon must be a CraftableWeapon");
+
+private:
+    AttachmentOptions choices;
+    size_t batchSize;
+    uint64_t chunkSize;
+
+    struct Counts{
+        uint64_t built = 0;
+        uint64_t rejected = 0;
+    };
+
+    template <class Rule, class Sink>
+    Counts work(Rule& legal, Sink& sink, size_t thread, atomic<uint64_t>& next) const
+    {
+        Counts counts;
+        uint64_t total = choices.combinations();
+        Builder builder;
+        vector<Weapon> batch(batchSize);
+        size_t filled = 0;
+        size_t digit[PART_COUNT] = {};
+        AttachmentId parts[PART_COUNT] = {};
+
+        while (true)
+        {
+            //Claim at most what is left, so the counter never passes total or wraps
+            uint64_t begin = next.load(memory_order_relaxed);
+            uint64_t end = begin;
+            do
+            {
+                if (begin >= total)
+                    break;
+                end = begin + min(chunkSize, total - begin);
+            }
+            while (!next.compare_exchange_weak(begin, end, memory_order_relaxed));
+            if (begin >= total)
+                break;
+
+            uint64_t k = begin;
+            for (int p = 0; p < PART_COUNT; p++)
+            {
+                const vector<AttachmentId>& o = choices.options[p];
+                if (o.empty())
+                    continue;
+                digit[p] = size_t(k % o.size());
+                k /= o.size();
+                parts[p] = o[digit[p]];
+                builder.attachPart(Part(p), parts[p]);
+            }
+
+            for (uint64_t i = begin; i < end; i++)
+            {
+                if (legal(static_cast<const AttachmentId*>(parts)))
+                {
+                    batch[filled++] = static_cast<Weapon&>(*builder.getResult());
+                    counts.built++;
+                    if (filled == batchSize)
+                    {
+                        sink(static_cast<const Weapon*>(batch.data()), filled, thread);
+                        filled = 0;
+                    }
+                }
+                else
+                    counts.rejected++;
+
+                for (int p = 0; p < PART_COUNT; p++)
+                {
+                    const vector<AttachmentId>& o = choices.options[p];
+                    if (o.empty())
+                        continue;
+                    bool carry = ++digit[p] == o.size();
+                    if (carry)
+                        digit[p] = 0;
+                    parts[p] = o[digit[p]];
+                    builder.attachPart(Part(p), parts[p]);
+                    if (!carry)
+                        break;
+                }
+            }
+        }
+        if (filled > 0)
+            sink(static_cast<const Weapon*>(batch.data()), filled, thread);
+        return counts;
+    }
+
+public:
+    LoadoutGenerator(const AttachmentOptions& options, size_t batch = 1024, uint64_t chunk = 4096)
+    {
+        choices = options;
+        batchSize = max<size_t>(batch, 1);
+        chunkSize = max<uint64_t>(chunk, 1);
+    }
+
+    uint64_t combinations() const
+    {
+        return choices.combinations();
+    }
+
+    size_t batchBytes() const
+    {
+        return batchSize * sizeof(Weapon);
+    }
+
+    template <class Rule, class Sink>
+    LoadoutReport run(Rule legal, Sink& sink, size_t threadCount) const
+    {
+        LoadoutReport report;
+        report.combinations = combinations();
+        report.threads = max<size_t>(threadCount, 1);
+
+        atomic<uint64_t> next{0};
+        vector<Counts> counts(report.threads);
+        vector<thread> threads;
+        Stopwatch clock;
+        for (size_t t = 0; t < report.threads; t++)
+            threads.emplace_back([&, t]
+            {
+                counts[t] = work(legal, sink, t, next);
+            });
+        for (auto& t : threads)
+            t.join();
+        report.seconds = clock.seconds();
+
+        for (auto& c : counts)
+        {
+            report.built += c.built;
+            report.rejected += c.rejected;
+        }
+        report.buildsPerSecond = report.seconds > 0 ? report.built / report.seconds : 0;
+        return report;
+    }
+};
+
+typedef LoadoutGenerator<ARBuilder> RifleLoadouts;
+typedef LoadoutGenerator<HandgunBuilder> HandgunLoadouts;
+
+
+//Balancing summary kept per thread, padded so threads do not share a cache line
+struct alignas(64) LoadoutTally{
+    uint64_t weapons = 0;
+    uint64_t checksum = 0;
+    uint64_t batches = 0;
+};
+
+template <class Weapon>
+struct LoadoutTallySink{
+    vector<LoadoutTally> tallies;
+
+    explicit LoadoutTallySink(size_t threads) : tallies(threads)
+    {
+    }
+
+    void operator()(const Weapon* batch, size_t count, size_t thread)
+    {
+        LoadoutTally& tally = tallies[thread];
+        for (size_t i = 0; i < count; i++)
+        {
+            uint64_t h = 0;
+            for (int p = 0; p < PART_COUNT; p++)
+                h = (h << 9 | h >> 55) ^ batch[i].part(Part(p));
+            tally.checksum += h * 0x9E3779B97F4A7C15ULL;
+        }
+        tally.weapons += count;
+        tally.batches++;
+    }
+
+    LoadoutTally total() const
+    {
+        LoadoutTally sum;
+        for (auto& t : tallies)
+        {
+            sum.weapons += t.weapons;
+            sum.checksum += t.checksum;
+            sum.batches += t.batches;
+        }
+        return sum;
+    }
+};
+
+
+void LoadoutGeneratorDemo()
+{
+    AttachmentOptions rifleParts;
+    rifleParts.add(RECEIVER, "Stock Receiver").addNumbered(RECEIVER, "Receiver Mk", 11)
+    .add(BARREL, "Stock Barrel").add(BARREL, "Long Barrel").add(BARREL, "Short Barrel")
+    .add(BARREL, "Heavy Barrel").addNumbered(BARREL, "Barrel", 6)
+    .add(HANDGUARD, "Stock Handguard").add(HANDGUARD, "Rail Handguard").addNumbered(HANDGUARD, "Handguard", 4)
+    .add(BIPOD, "No Bipod").add(BIPOD, "Bipod").add(BIPOD, "Folding Bipod")
+    .add(STOCK, "Basic Stock").add(STOCK, "Precision Stock").add(STOCK, "Collapsible Stock")
+    .addNumbered(STOCK, "Stock", 5)
+    .add(GRIP, "Stock Pistol Grip").add(GRIP, "Ergonomic Pistol Grip").addNumbered(GRIP, "Grip", 6)
+    .add(MAGAZINE, "Stock Magazine").add(MAGAZINE, "40-round Magazine").add(MAGAZINE, "10-round Magazine")
+    .add(MAGAZINE, "Drum Magazine").addNumbered(MAGAZINE, "Magazine", 6);
+
+    AttachmentOptions handgunParts;
+    handgunParts.add(RECEIVER, "Stock Receiver").addNumbered(RECEIVER, "Slide", 11)
+    .add(BARREL, "Stock Barrel").add(BARREL, "Compensated Barrel").addNumbered(BARREL, "Pistol Barrel", 8)
+    .add(GRIP, "Stock Pistol Grip").add(GRIP, "Ergonomic Pistol Grip").addNumbered(GRIP, "Pistol Grip", 10)
+    .add(MAGAZINE, "Stock Magazine").add(MAGAZINE, "21-round Magazine").addNumbered(MAGAZINE, "Pistol Magazine", 8);
+
+    //A bipod only goes on a long or heavy barrel
+    AttachmentId noBipod = attachmentId("No Bipod");
+    AttachmentId longBarrel = attachmentId("Long Barrel");
+    AttachmentId heavyBarrel = attachmentId("Heavy Barrel");
+    auto rifleRule = [=](const AttachmentId* parts)
+    {
+        return parts[BIPOD] == noBipod || parts[BARREL] == longBarrel || parts[BARREL] == heavyBarrel;
+    };
+    auto anything = [](const AttachmentId*) { return true; };
+
+    RifleLoadouts rifles(rifleParts);
+    HandgunLoadouts handguns(handgunParts);
+
+    for (size_t threads : {1, 2, 4})
+    {
+        LoadoutTallySink<AssaultRifle> rifleSink(threads);
+        LoadoutReport r = rifles.run(rifleRule, rifleSink, threads);
+        LoadoutTally rifleTally = rifleSink.total();
+
+        LoadoutTallySink<Handgun> handgunSink(threads);
+        LoadoutReport h = handguns.run(anything, handgunSink, threads);
+
+        cout<<threads<<" thread(s):"<<endl;
+        cout<<"  AssaultRifle: "<<r.combinations<<" combinations, "<<r.built<<" built, "<<r.rejected
+            <<" illegal, "<<r.seconds * 1000<<" ms ("<<(uint64_t)r.buildsPerSecond<<" builds/s), checksum "
+            <<hex<<rifleTally.checksum<<dec<<endl;
+        cout<<"  Handgun: "<<h.combinations<<" combinations, "<<h.built<<" built, "
+            <<h.seconds * 1000<<" ms, checksum "<<hex<<handgunSink.total().checksum<<dec<<endl;
+    }
+
+    cout<<"Weapon storage: "<<rifles.batchBytes()<<" bytes per thread instead of "
+        <<rifles.combinations() * sizeof(AssaultRifle) / 1024<<" KB for every rifle"<<endl;
+}
+
+#endif //LAB_2_LOADOUTGENERATOR_H
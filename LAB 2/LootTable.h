@@ -0,0 +1,115 @@
+#ifndef LAB_2_LOOTTABLE_H
+#define LAB_2_LOOTTABLE_H
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+
+//Weighted drop table built with Vose's alias method. Every column holds an item, a threshold
+//and an alias: one 64-bit random number picks the column with its low half and chooses between
+//the item and its alias with the high half, so a draw costs the same for 3 items or 3 million.
+class AliasTable{
+private:
+    struct Column{
+        uint32_t threshold;
+        uint32_t alias;
+    };
+
+    vector<Column> columns;
+
+public:
+    AliasTable() = default;
+
+    explicit AliasTable(const vector<double>& weights)
+    {
+        build(weights);
+    }
+
+    //Throws invalid_argument for a negative, NaN or infinite weight; all zero means all equal
+    void build(const vector<double>& weights)
+    {
+        size_t n = weights.size();
+        double total = 0;
+        for (double w : weights)
+        {
+            if (!(w >= 0) || !std::isfinite(w))
+                throw invalid_argument("AliasTable: weights must be finite and not negative");
+            total += w;
+        }
+        if (!std::isfinite(total))
+            throw invalid_argument("AliasTable: weights add up to more than a double holds");
+
+        columns.assign(n, Column{UINT32_MAX, 0});
+        if (n == 0 || total <= 0)
+        {
+            for (size_t i = 0; i < n; i++)
+                columns[i].alias = uint32_t(i);
+            return;
+        }
+
+        //Scaled so the average column holds exactly 1
+        vector<double> scaled(n);
+        vector<uint32_t> small, large;
+        for (size_t i = 0; i < n; i++)
+        {
+            scaled[i] = weights[i] * n / total;
+            (scaled[i] < 1 ? small : large).push_back(uint32_t(i));
+        }
+
+        while (!small.empty() && !large.empty())
+        {
+            uint32_t s = small.back();
+            small.pop_back();
+            uint32_t l = large.back();
+            columns[s].threshold = uint32_t(scaled[s] * 4294967296.0);
+            columns[s].alias = l;
+            scaled[l] -= 1 - scaled[s];
+            if (scaled[l] < 1)
+            {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+
+        //Whatever is left is full up to rounding error
+        for (uint32_t i : small)
+            columns[i] = Column{UINT32_MAX, i};
+        for (uint32_t i : large)
+            columns[i] = Column{UINT32_MAX, i};
+    }
+
+    size_t size() const
+    {
+        return columns.size();
+    }
+
+    template <class Rng>
+    uint32_t sample(Rng& gen) const
+    {
+        static_assert(sizeof(typename Rng::result_type) >= 8, "AliasTable needs 64-bit random numbers");
+        assert(!columns.empty());
+        uint64_t r = gen();
+        uint32_t column = uint32_t((uint64_t(uint32_t(r)) * columns.size()) >> 32);
+        const Column& c = columns[column];
+        return uint32_t(r >> 32) < c.threshold ? column : c.alias;
+    }
+
+    template <class Rng>
+    void sample(Rng& gen, uint32_t* out, size_t n) const
+    {
+        static_assert(sizeof(typename Rng::result_type) >= 8, "AliasTable needs 64-bit random numbers");
+        assert(n == 0 || !columns.empty());
+        const Column* c = columns.data();
+        uint64_t size = columns.size();
+        for (size_t i = 0; i < n; i++)
+        {
+            uint64_t r = gen();
+            uint32_t column = uint32_t((uint64_t(uint32_t(r)) * size) >> 32);
+            out[i] = uint32_t(r >> 32) < c[column].threshold ? column : c[column].alias;
+        }
+    }
+};
+
+#endif //LAB_2_LOOTTABLE_H
@@ -0,0 +1,294 @@
+#ifndef LAB_2_RANDOM_H
+#define LAB_2_RANDOM_H
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <random>
+
+#include "Bench.h"
+
+
+//Small, fast generators for the weapon code, replacing rand().
+//A run has one seed; every stream is derived from it, so a run is reproduced by reusing the
+//seed. Each thread gets its own stream, so threads never share generator state.
+
+uint64_t rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+//SplitMix64 step: turns any seed, even 0 or 1, into a well mixed 64-bit value
+uint64_t splitMix64(uint64_t& state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+//Seed of stream number `stream` under a base seed; different streams get unrelated seeds
+uint64_t deriveSeed(uint64_t base, uint64_t stream)
+{
+    uint64_t state = base ^ (stream * 0xD1B54A32D192ED03ULL);
+    splitMix64(state);
+    return splitMix64(state);
+}
+
+
+//xoshiro256++: 64-bit output, 256-bit state. The default generator.
+class Xoshiro256{
+private:
+    uint64_t s[4];
+
+public:
+    typedef uint64_t result_type;
+
+    explicit Xoshiro256(uint64_t seed = 0)
+    {
+        this->seed(seed);
+    }
+
+    void seed(uint64_t seed)
+    {
+        for (auto& word : s)
+            word = splitMix64(seed);
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return numeric_limits<result_type>::max(); }
+
+    result_type operator()()
+    {
+        uint64_t result = rotl(s[0] + s[3], 23) + s[0];
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+};
+
+
+//PCG32 (XSH RR): 32-bit output, 64-bit state, with selectable stream. Cheaper to store
+//when many small generators are needed.
+class Pcg32{
+private:
+    uint64_t state;
+    uint64_t increment;
+
+public:
+    typedef uint32_t result_type;
+
+    explicit Pcg32(uint64_t seed = 0, uint64_t stream = 0)
+    {
+        state = 0;
+        increment = (stream << 1) | 1;
+        (*this)();
+        state += seed;
+        (*this)();
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return numeric_limits<result_type>::max(); }
+
+    result_type operator()()
+    {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + increment;
+        uint32_t xorshifted = uint32_t(((old >> 18) ^ old) >> 27);
+        uint32_t rot = uint32_t(old >> 59);
+        return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+    }
+};
+
+
+//Four interleaved xoshiro256++ lanes for filling buffers in bulk. The lanes are independent
+//and stored lane-by-lane, so the compiler can run them in vector registers.
+class Xoshiro256x4{
+private:
+    static const int LANES = 4;
+    uint64_t s[4][LANES];
+
+public:
+    explicit Xoshiro256x4(uint64_t seed = 0)
+    {
+        for (int lane = 0; lane < LANES; lane++)
+        {
+            uint64_t laneSeed = deriveSeed(seed, uint64_t(lane));
+            for (int w = 0; w < 4; w++)
+                s[w][lane] = splitMix64(laneSeed);
+        }
+    }
+
+    //One number from every lane
+    void next(uint64_t* out)
+    {
+        for (int lane = 0; lane < LANES; lane++)
+        {
+            out[lane] = rotl(s[0][lane] + s[3][lane], 23) + s[0][lane];
+            uint64_t t = s[1][lane] << 17;
+            s[2][lane] ^= s[0][lane];
+            s[3][lane] ^= s[1][lane];
+            s[1][lane] ^= s[2][lane];
+            s[0][lane] ^= s[3][lane];
+            s[2][lane] ^= t;
+            s[3][lane] = rotl(s[3][lane], 45);
+        }
+    }
+
+    void fill(uint64_t* out, size_t n)
+    {
+        //Work on a local copy so the compiler knows out cannot alias the state
+        uint64_t s0[LANES], s1[LANES], s2[LANES], s3[LANES];
+        for (int lane = 0; lane < LANES; lane++)
+        {
+            s0[lane] = s[0][lane];
+            s1[lane] = s[1][lane];
+            s2[lane] = s[2][lane];
+            s3[lane] = s[3][lane];
+        }
+
+        size_t i = 0;
+        for (; i + LANES <= n; i += LANES)
+        {
+            for (int lane = 0; lane < LANES; lane++)
+            {
+                out[i + lane] = rotl(s0[lane] + s3[lane], 23) + s0[lane];
+                uint64_t t = s1[lane] << 17;
+                s2[lane] ^= s0[lane];
+                s3[lane] ^= s1[lane];
+                s1[lane] ^= s2[lane];
+                s0[lane] ^= s3[lane];
+                s2[lane] ^= t;
+                s3[lane] = rotl(s3[lane], 45);
+            }
+        }
+
+        for (int lane = 0; lane < LANES; lane++)
+        {
+            s[0][lane] = s0[lane];
+            s[1][lane] = s1[lane];
+            s[2][lane] = s2[lane];
+            s[3][lane] = s3[lane];
+        }
+        if (i < n)
+        {
+            uint64_t rest[LANES];
+            next(rest);
+            for (int lane = 0; i < n; i++, lane++)
+                out[i] = rest[lane];
+        }
+    }
+};
+
+
+//Run seed and per-thread streams. Threads are numbered in the order they first ask for a
+//generator and get stream deriveSeed(run seed, number). When thread start order varies
+//between runs, give each worker an explicit stream instead: Xoshiro256(deriveSeed(runSeed(), id)).
+struct RandomRun{
+    atomic<uint64_t> seed{0x5EEDULL};
+    atomic<uint64_t> generation{0};
+    atomic<uint64_t> threads{0};
+};
+
+RandomRun randomRun;
+
+void seedRandom(uint64_t seed)
+{
+    randomRun.seed.store(seed);
+    randomRun.threads.store(0);
+    randomRun.generation.fetch_add(1);
+}
+
+uint64_t runSeed()
+{
+    return randomRun.seed.load(memory_order_relaxed);
+}
+
+Xoshiro256& threadRandom()
+{
+    thread_local Xoshiro256 gen;
+    thread_local uint64_t generation = UINT64_MAX;
+    uint64_t current = randomRun.generation.load(memory_order_relaxed);
+    if (generation != current)
+    {
+        generation = current;
+        gen.seed(deriveSeed(runSeed(), randomRun.threads.fetch_add(1)));
+    }
+    return gen;
+}
+
+//Unbiased enough for game use: multiply-shift of 32 random bits, no modulo
+uint32_t randomBelow(uint32_t n)
+{
+    return uint32_t((uint64_t(uint32_t(threadRandom()() >> 32)) * n) >> 32);
+}
+
+//Throughput on a cache-sized buffer, so it measures the generators rather than memory
+void RandomDemo()
+{
+    const size_t size = 4096;
+    const size_t rounds = 5000;
+    vector<uint64_t> buffer(size);
+    uint64_t checksum = 0;
+
+    mt19937_64 mt(1);
+    Stopwatch clock;
+    for (size_t r = 0; r < rounds; r++)
+    {
+        for (auto& x : buffer)
+            x = mt();
+        checksum += buffer[r % size];
+    }
+    double mtSeconds = clock.seconds();
+
+    Xoshiro256 xoshiro(1);
+    clock.reset();
+    for (size_t r = 0; r < rounds; r++)
+    {
+        for (auto& x : buffer)
+            x = xoshiro();
+        checksum += buffer[r % size];
+    }
+    double xoshiroSeconds = clock.seconds();
+
+    Pcg32 pcg(1);
+    clock.reset();
+    for (size_t r = 0; r < rounds; r++)
+    {
+        for (auto& x : buffer)
+            x = pcg();
+        checksum += buffer[r % size];
+    }
+    double pcgSeconds = clock.seconds();
+
+    Xoshiro256x4 lanes(1);
+    clock.reset();
+    for (size_t r = 0; r < rounds; r++)
+    {
+        lanes.fill(buffer.data(), size);
+        checksum += buffer[r % size];
+    }
+    double fillSeconds = clock.seconds();
+
+    double n = double(size * rounds);
+    cout<<uint64_t(n)<<" numbers (checksum "<<checksum % 1000<<"):"<<endl;
+    cout<<"  mt19937_64:          "<<mtSeconds * 1e9 / n<<" ns/number"<<endl;
+    cout<<"  Xoshiro256:          "<<xoshiroSeconds * 1e9 / n<<" ns/number"<<endl;
+    cout<<"  Pcg32:               "<<pcgSeconds * 1e9 / n<<" ns/number"<<endl;
+    cout<<"  Xoshiro256x4::fill:  "<<fillSeconds * 1e9 / n<<" ns/number"<<endl;
+
+    //Same run seed, same numbers
+    uint64_t saved = runSeed();
+    seedRandom(2024);
+    uint64_t first = threadRandom()();
+    seedRandom(2024);
+    cout<<"Run seed 2024 reproduces: "<<(threadRandom()() == first ? "yes" : "no")<<endl;
+    seedRandom(saved);
+}
+
+#endif //LAB_2_RANDOM_H
@@ -0,0 +1,433 @@
+#ifndef LAB_2_WEAPONCATALOG_H
+#define LAB_2_WEAPONCATALOG_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+enum WeaponClass{
+    SHOTGUN,
+    RIFLE,
+    WEAPON_CLASS_COUNT
+};
+
+const char* weaponClassName(WeaponClass weaponClass)
+{
+    static const char* names[WEAPON_CLASS_COUNT] = {"shotgun", "rifle"};
+    return names[weaponClass];
+}
+
+
+//One catalog entry: the shared, immutable part of a weapon. This is also the record layout of
+//the catalog file; the name is found by offset from the record itself, so a record works
+//wherever the file is mapped.
+struct WeaponModel{
+    int32_t nameOffset;
+    uint8_t weaponClass;
+    uint8_t reserved;
+    uint16_t damage;
+    uint16_t fireRate;
+    uint16_t magazine;
+    float dropWeight;
+
+    const char* name() const
+    {
+        return reinterpret_cast<const char*>(this) + nameOffset;
+    }
+};
+
+static_assert(sizeof(WeaponModel) == 16, "WeaponModel is a file record");
+
+
+//Catalog file ("WCAT"): this header, then WEAPON_CLASS_COUNT + 1 class start indices, then the
+//models sorted by class, then the NUL-terminated names
+struct CatalogHeader{
+    char magic[4];
+    uint32_t version;
+    uint32_t classCount;
+    uint32_t modelCount;
+    uint32_t classIndexOffset;
+    uint32_t modelsOffset;
+    uint32_t stringsOffset;
+    uint32_t stringsSize;
+};
+
+const uint32_t CATALOG_VERSION = 1;
+
+
+//Every weapon model, grouped by class, read straight out of a catalog image.
+//The image is either a buffer the catalog owns or a read-only mapping of a catalog file
+//(on Windows the file is read into the buffer); either way it is never changed and nothing is parsed.
+class WeaponCatalog{
+private:
+    vector<char> owned;
+    void* mapping = nullptr;
+    size_t mappedSize = 0;
+    const CatalogHeader* header = nullptr;
+    const uint32_t* classBegin = nullptr;
+    const WeaponModel* entries = nullptr;
+
+    WeaponCatalog() = default;
+
+    //The image comes from disk, so nothing in it is trusted: the header, class index and every
+    //record's name must lie inside the image before any of it is used
+    bool attach(const char* image, size_t size, string& error)
+    {
+        header = reinterpret_cast<const CatalogHeader*>(image);
+        if (size < sizeof(CatalogHeader) || memcmp(header->magic, "WCAT", 4) != 0)
+        {
+            error = "not a weapon catalog";
+            return false;
+        }
+        if (header->version != CATALOG_VERSION || header->classCount != WEAPON_CLASS_COUNT)
+        {
+            error = "unsupported catalog version";
+            return false;
+        }
+        uint64_t indexEnd = uint64_t(header->classIndexOffset) + (WEAPON_CLASS_COUNT + 1) * sizeof(uint32_t);
+        uint64_t modelsEnd = uint64_t(header->modelsOffset) + uint64_t(header->modelCount) * sizeof(WeaponModel);
+        uint64_t stringsEnd = uint64_t(header->stringsOffset) + header->stringsSize;
+        if (indexEnd > size || modelsEnd > size || stringsEnd > size
+            || header->classIndexOffset % alignof(uint32_t) != 0 || header->modelsOffset % alignof(WeaponModel) != 0)
+        {
+            error = "truncated catalog";
+            return false;
+        }
+        classBegin = reinterpret_cast<const uint32_t*>(image + header->classIndexOffset);
+        entries = reinterpret_cast<const WeaponModel*>(image + header->modelsOffset);
+        for (int c = 0; c < WEAPON_CLASS_COUNT; c++)
+            if (classBegin[c] > classBegin[c + 1])
+            {
+                error = "corrupt class index";
+                return false;
+            }
+        if (classBegin[0] != 0 || classBegin[WEAPON_CLASS_COUNT] != header->modelCount)
+        {
+            error = "corrupt class index";
+            return false;
+        }
+
+        //The string block ends in a NUL, so a name starting inside it is terminated inside it
+        if (header->modelCount > 0 && (header->stringsSize == 0 || image[stringsEnd - 1] != '\0'))
+        {
+            error = "corrupt name table";
+            return false;
+        }
+        for (uint32_t i = 0; i < header->modelCount; i++)
+        {
+            int64_t name = int64_t(header->modelsOffset) + int64_t(i) * int64_t(sizeof(WeaponModel))
+                           + entries[i].nameOffset;
+            if (name < int64_t(header->stringsOffset) || name >= int64_t(stringsEnd))
+            {
+                error = "corrupt name of model " + to_string(i);
+                return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    WeaponCatalog(const WeaponCatalog&) = delete;
+
+    ~WeaponCatalog()
+    {
+#ifndef _WIN32
+        if (mapping != nullptr)
+            munmap(mapping, mappedSize);
+#endif
+    }
+
+    //Catalog over an image already in memory (see CatalogWriter::build)
+    static unique_ptr<WeaponCatalog> fromImage(vector<char> image, string& error)
+    {
+        unique_ptr<WeaponCatalog> catalog(new WeaponCatalog());
+        catalog->owned = move(image);
+        if (!catalog->attach(catalog->owned.data(), catalog->owned.size(), error))
+            return nullptr;
+        return catalog;
+    }
+
+    //Maps a catalog file read-only; null on failure, with the reason in error
+    static unique_ptr<WeaponCatalog> open(const string& path, string& error)
+    {
+#ifdef _WIN32
+        ifstream in(path, ios::binary);
+        if (!in)
+        {
+            error = "cannot open " + path;
+            return nullptr;
+        }
+        vector<char> image((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        if (in.bad() || image.empty())
+        {
+            error = "cannot read " + path;
+            return nullptr;
+        }
+        return fromImage(move(image), error);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            error = "cannot open " + path;
+            return nullptr;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0)
+        {
+            close(fd);
+            error = "cannot read " + path;
+            return nullptr;
+        }
+        void* mapping = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            error = "cannot map " + path;
+            return nullptr;
+        }
+
+        unique_ptr<WeaponCatalog> catalog(new WeaponCatalog());
+        catalog->mapping = mapping;
+        catalog->mappedSize = size_t(info.st_size);
+        if (!catalog->attach(static_cast<const char*>(mapping), catalog->mappedSize, error))
+            return nullptr;
+        return catalog;
+#endif
+    }
+
+    //The six models the lab started with
+    static const WeaponCatalog& builtin();
+
+    //The catalog file the build produces, or the built-in models if it is missing
+    static const WeaponCatalog& standard();
+
+    const WeaponModel* models(WeaponClass weaponClass) const
+    {
+        return entries + classBegin[weaponClass];
+    }
+
+    size_t count(WeaponClass weaponClass) const
+    {
+        return classBegin[weaponClass + 1] - classBegin[weaponClass];
+    }
+
+    size_t size() const
+    {
+        return header->modelCount;
+    }
+
+    bool isMapped() const
+    {
+        return mapping != nullptr;
+    }
+};
+
+
+//Collects models and lays them out as a catalog image. Also reads and writes the
+//human-readable source format, one model per line:
+//    class,name,damage,fireRate,magazine,dropWeight
+//Blank lines and lines starting with # are skipped; names cannot contain commas.
+class CatalogWriter{
+private:
+    struct Entry{
+        string name;
+        WeaponClass weaponClass;
+        uint16_t damage;
+        uint16_t fireRate;
+        uint16_t magazine;
+        float dropWeight;
+    };
+
+    vector<Entry> entries;
+
+public:
+    void add(const string& name, WeaponClass weaponClass, uint16_t damage, uint16_t fireRate,
+             uint16_t magazine, float dropWeight)
+    {
+        entries.push_back(Entry{name, weaponClass, damage, fireRate, magazine, dropWeight});
+    }
+
+    size_t size() const
+    {
+        return entries.size();
+    }
+
+    bool readSource(istream& in, string& error)
+    {
+        string line;
+        size_t lineNumber = 0;
+        while (getline(in, line))
+        {
+            lineNumber++;
+            if (line.empty() || line[0] == '#')
+                continue;
+            vector<string> fields;
+            stringstream split(line);
+            string field;
+            while (getline(split, field, ','))
+                fields.push_back(field);
+
+            int weaponClass = -1;
+            for (int c = 0; c < WEAPON_CLASS_COUNT && fields.size() == 6; c++)
+                if (fields[0] == weaponClassName(WeaponClass(c)))
+                    weaponClass = c;
+            if (weaponClass < 0 || fields[1].empty())
+            {
+                error = "line " + to_string(lineNumber) + ": expected class,name,damage,fireRate,magazine,dropWeight";
+                return false;
+            }
+            //The whole field must be the number, in range; drop weights must be finite and not negative
+            auto count = [](const string& text) -> uint16_t
+            {
+                size_t used = 0;
+                unsigned long value = stoul(text, &used);
+                if (used != text.size() || text[0] == '-' || value > UINT16_MAX)
+                    throw out_of_range(text);
+                return uint16_t(value);
+            };
+            auto weight = [](const string& text) -> float
+            {
+                size_t used = 0;
+                float value = stof(text, &used);
+                if (used != text.size() || !std::isfinite(value) || value < 0)
+                    throw out_of_range(text);
+                return value;
+            };
+            try
+            {
+                add(fields[1], WeaponClass(weaponClass), count(fields[2]), count(fields[3]), count(fields[4]),
+                    weight(fields[5]));
+            }
+            catch (const exception&)
+            {
+                error = "line " + to_string(lineNumber) + ": bad number";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void writeSource(ostream& out) const
+    {
+        out<<"#class,name,damage,fireRate,magazine,dropWeight"<<endl;
+        for (auto& e : entries)
+            out<<weaponClassName(e.weaponClass)<<","<<e.name<<","<<e.damage<<","<<e.fireRate<<","
+               <<e.magazine<<","<<e.dropWeight<<"\n";
+    }
+
+    vector<char> build() const
+    {
+        vector<const Entry*> sorted;
+        for (auto& e : entries)
+            sorted.push_back(&e);
+        stable_sort(sorted.begin(), sorted.end(),
+                    [](const Entry* a, const Entry* b) { return a->weaponClass < b->weaponClass; });
+
+        CatalogHeader h = {};
+        memcpy(h.magic, "WCAT", 4);
+        h.version = CATALOG_VERSION;
+        h.classCount = WEAPON_CLASS_COUNT;
+        h.modelCount = uint32_t(sorted.size());
+        h.classIndexOffset = sizeof(CatalogHeader);
+        h.modelsOffset = h.classIndexOffset + (WEAPON_CLASS_COUNT + 1) * sizeof(uint32_t);
+        h.stringsOffset = h.modelsOffset + h.modelCount * sizeof(WeaponModel);
+        for (auto e : sorted)
+            h.stringsSize += uint32_t(e->name.size() + 1);
+
+        vector<char> image(h.stringsOffset + h.stringsSize);
+        memcpy(image.data(), &h, sizeof(h));
+
+        uint32_t classBegin[WEAPON_CLASS_COUNT + 1] = {};
+        for (auto e : sorted)
+            classBegin[e->weaponClass + 1]++;
+        for (int c = 0; c < WEAPON_CLASS_COUNT; c++)
+            classBegin[c + 1] += classBegin[c];
+        memcpy(image.data() + h.classIndexOffset, classBegin, sizeof(classBegin));
+
+        uint32_t name = h.stringsOffset;
+        for (size_t i = 0; i < sorted.size(); i++)
+        {
+            const Entry& e = *sorted[i];
+            uint32_t record = h.modelsOffset + uint32_t(i * sizeof(WeaponModel));
+            WeaponModel model = {};
+            model.nameOffset = int32_t(name - record);
+            model.weaponClass = uint8_t(e.weaponClass);
+            model.damage = e.damage;
+            model.fireRate = e.fireRate;
+            model.magazine = e.magazine;
+            model.dropWeight = e.dropWeight;
+            memcpy(image.data() + record, &model, sizeof(model));
+            memcpy(image.data() + name, e.name.c_str(), e.name.size() + 1);
+            name += uint32_t(e.name.size() + 1);
+        }
+        return image;
+    }
+
+    bool save(const string& path) const
+    {
+        vector<char> image = build();
+        ofstream out(path, ios::binary);
+        out.write(image.data(), streamsize(image.size()));
+        return bool(out);
+    }
+
+    //Made-up models for load tests
+    static CatalogWriter synthetic(size_t count, uint64_t seed)
+    {
+        CatalogWriter writer;
+        Xoshiro256 gen(seed);
+        for (size_t i = 0; i < count; i++)
+        {
+            WeaponClass weaponClass = WeaponClass(gen() % WEAPON_CLASS_COUNT);
+            string name = string(weaponClass == SHOTGUN ? "Shotgun" : "Rifle") + " Mk" + to_string(i);
+            writer.add(name, weaponClass, uint16_t(20 + gen() % 80), uint16_t(60 + gen() % 900),
+                       uint16_t(2 + gen() % 60), float(1 + gen() % 10));
+        }
+        return writer;
+    }
+};
+
+
+const WeaponCatalog& WeaponCatalog::builtin()
+{
+    static unique_ptr<WeaponCatalog> catalog = []
+    {
+        CatalogWriter writer;
+        writer.add("Benelli M4 Super 90", SHOTGUN, 88, 300, 7, 1);
+        writer.add("Remington 870", SHOTGUN, 90, 60, 6, 3);
+        writer.add("Mossberg 500", SHOTGUN, 90, 60, 8, 4);
+        writer.add("M4A1", RIFLE, 33, 800, 30, 5);
+        writer.add("MK17", RIFLE, 46, 600, 20, 2);
+        writer.add("MK18", RIFLE, 31, 850, 30, 3);
+        string error;
+        return WeaponCatalog::fromImage(writer.build(), error);
+    }();
+    return *catalog;
+}
+
+//Where the build puts the converted weapons.txt
+#ifndef WEAPON_CATALOG_FILE
+#define WEAPON_CATALOG_FILE "weapons.wcat"
+#endif
+
+const WeaponCatalog& WeaponCatalog::standard()
+{
+    static unique_ptr<WeaponCatalog> catalog = []
+    {
+        string error;
+        return WeaponCatalog::open(WEAPON_CATALOG_FILE, error);
+    }();
+    return catalog != nullptr ? *catalog : builtin();
+}
+
+#endif //LAB_2_WEAPONCATALOG_H
@@ -0,0 +1,67 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <memory>
+using namespace std;
+
+#include "Random.h"
+#include "WeaponCatalog.h"
+
+//Converts a weapon catalog source file to the binary catalog the factories map.
+//    WEAPON_CATALOG <source.txt> <catalog.wcat>
+//    WEAPON_CATALOG --generate <source.txt> <models>
+
+void usage()
+{
+    cout<<"Usage: WEAPON_CATALOG <source.txt> <catalog.wcat>"<<endl;
+    cout<<"       WEAPON_CATALOG --generate <source.txt> <models>"<<endl;
+}
+
+int main(int argc, char** argv)
+{
+    vector<string> args(argv + 1, argv + argc);
+    if (args.size() != 2 && args.size() != 3)
+    {
+        usage();
+        return 1;
+    }
+
+    if (args[0] == "--generate")
+    {
+        if (args.size() != 3)
+        {
+            usage();
+            return 1;
+        }
+        ofstream out(args[1]);
+        CatalogWriter::synthetic(stoul(args[2]), 1).writeSource(out);
+        if (!out)
+        {
+            cout<<"Cannot write "<<args[1]<<endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    ifstream in(args[0]);
+    if (!in)
+    {
+        cout<<"Cannot open "<<args[0]<<endl;
+        return 1;
+    }
+    CatalogWriter writer;
+    string error;
+    if (!writer.readSource(in, error))
+    {
+        cout<<args[0]<<": "<<error<<endl;
+        return 1;
+    }
+    if (!writer.save(args[1]))
+    {
+        cout<<"Cannot write "<<args[1]<<endl;
+        return 1;
+    }
+    cout<<writer.size()<<" models written to "<<args[1]<<endl;
+    return 0;
+}
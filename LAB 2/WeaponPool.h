@@ -0,0 +1,135 @@
+#ifndef LAB_2_WEAPONPOOL_H
+#define LAB_2_WEAPONPOOL_H
+
+#include <cstdint>
+#include <memory>
+#include <new>
+
+
+//Counts shared by every weapon pool
+struct PoolCounters{
+    uint64_t heapAllocations = 0;
+    uint64_t acquired = 0;
+    uint64_t recycled = 0;
+};
+
+//Defined once, in the program. Kit plugins are built with KIT_PLUGIN_BUILD and use the program's
+//copy, which it exports, so they count into the same totals. A Windows DLL cannot take data from
+//whichever program loads it, so there each plugin keeps its own counters.
+#if defined(KIT_PLUGIN_BUILD) && !defined(_WIN32)
+extern PoolCounters poolCounters;
+#else
+PoolCounters poolCounters;
+#endif
+
+
+//Deleter that hands the object back to its pool instead of freeing it.
+//A handle made without a pool, e.g. PrimaryHandle(new MachineGun), deletes its object.
+template <class Base>
+struct Recycler{
+    void (*recycle)(Base*) = nullptr;
+
+    void operator()(Base* object) const
+    {
+        if (recycle != nullptr)
+            recycle(object);
+        else
+            delete object;
+    }
+};
+
+
+//Free-list pool for one weapon type. Storage is taken from the heap in chunks and never returned
+//while the program runs; released objects are destroyed in place and their slot goes back on
+//the free list, so once the pool is warm making a weapon costs no heap call.
+//One pool per type, shared by all factories. Not thread-safe.
+template <class T>
+class WeaponPool{
+private:
+    union Slot{
+        Slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    static const size_t CHUNK = 64;
+
+    vector<unique_ptr<Slot[]>> chunks;
+    Slot* freeList = nullptr;
+    size_t capacity = 0;
+    size_t live = 0;
+
+    WeaponPool() = default;
+
+    void grow()
+    {
+        chunks.emplace_back(new Slot[CHUNK]);
+        poolCounters.heapAllocations++;
+        Slot* chunk = chunks.back().get();
+        for (size_t i = 0; i < CHUNK; i++)
+        {
+            chunk[i].next = freeList;
+            freeList = &chunk[i];
+        }
+        capacity += CHUNK;
+    }
+
+    template <class Base>
+    static void recycle(Base* object)
+    {
+        instance().release(static_cast<T*>(object));
+    }
+
+public:
+    WeaponPool(const WeaponPool&) = delete;
+
+    static WeaponPool& instance()
+    {
+        static WeaponPool pool;
+        return pool;
+    }
+
+    //Makes sure the next n weapons can be made without touching the heap
+    void prewarm(size_t n)
+    {
+        while (capacity < live + n)
+            grow();
+    }
+
+    template <class Base>
+    unique_ptr<Base, Recycler<Base>> make()
+    {
+        if (freeList == nullptr)
+            grow();
+        Slot* slot = freeList;
+        freeList = slot->next;
+        T* object = new (slot->storage) T();
+        live++;
+        poolCounters.acquired++;
+
+        Recycler<Base> recycler;
+        recycler.recycle = &WeaponPool::recycle<Base>;
+        return unique_ptr<Base, Recycler<Base>>(object, recycler);
+    }
+
+    void release(T* object)
+    {
+        object->~T();
+        Slot* slot = reinterpret_cast<Slot*>(object);
+        slot->next = freeList;
+        freeList = slot;
+        live--;
+        poolCounters.recycled++;
+    }
+
+    size_t size() const
+    {
+        return capacity;
+    }
+
+    size_t inUse() const
+    {
+        return live;
+    }
+};
+
+#endif //LAB_2_WEAPONPOOL_H
@@ -0,0 +1,37 @@
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "../KitPlugin.h"
+
+
+class CombatShotgun : public PrimaryWeapon{
+public:
+    void equipPrimary() override final
+    {
+        cout<<"Equipping Primary : Combat Shotgun";
+    }
+
+    const char* name() const override final
+    {
+        return "Combat Shotgun";
+    }
+};
+
+class MachinePistol : public SecondaryWeapon{
+public:
+    void equipSecondary() override final
+    {
+        cout<<"Equipping Secondary : Machine Pistol";
+    }
+
+    const char* name() const override final
+    {
+        return "Machine Pistol";
+    }
+};
+
+typedef StaticKitAdapter<CombatShotgun, MachinePistol> BreacherKitFactory;
+
+KIT_PLUGIN(BreacherKitFactory)
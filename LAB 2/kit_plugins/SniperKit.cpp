@@ -0,0 +1,37 @@
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "../KitPlugin.h"
+
+
+class SniperRifle : public PrimaryWeapon{
+public:
+    void equipPrimary() override final
+    {
+        cout<<"Equipping Primary : Sniper Rifle";
+    }
+
+    const char* name() const override final
+    {
+        return "Sniper Rifle";
+    }
+};
+
+class Revolver : public SecondaryWeapon{
+public:
+    void equipSecondary() override final
+    {
+        cout<<"Equipping Secondary : Revolver";
+    }
+
+    const char* name() const override final
+    {
+        return "Revolver";
+    }
+};
+
+typedef StaticKitAdapter<SniperRifle, Revolver> SniperKitFactory;
+
+KIT_PLUGIN(SniperKitFactory)
@@ -6,22 +6,63 @@ using namespace std;
 
 #include "FactoryMethod.h"
 #include "AbstractFactory.h"
+#include "KitRegistry.h"
 #include "Builder+Prototype.h"
+#include "LoadoutGenerator.h"
 #include "Singleton.h"
 
 int main()
 {
-    srand(time(0));
+    seedRandom(uint64_t(time(0)));
 
     cout<<"Abstract Factory"<<endl;
     AbstractFactoryDemo();
     cout<<endl<<endl;
+    cout<<"Kit Pools"<<endl;
+    KitPoolDemo();
+    cout<<endl<<endl;
+    cout<<"Static Kit Factories"<<endl;
+    StaticKitFactoryDemo();
+    cout<<endl<<endl;
+    cout<<"Kit Batches"<<endl;
+    KitBatchDemo();
+    cout<<endl<<endl;
+    cout<<"Kit Plugins"<<endl;
+    KitPluginDemo();
+    cout<<endl<<endl;
     cout<<"Factory Method"<<endl;
     FactoryMethodDemo();
     cout<<endl<<endl;
+    cout<<"Weapon Catalog"<<endl;
+    WeaponCatalogDemo();
+    cout<<endl<<endl;
+    cout<<"Loot Tables"<<endl;
+    LootTableDemo();
+    cout<<endl<<endl;
+    cout<<"Catalog File"<<endl;
+    CatalogFileDemo();
+    cout<<endl<<endl;
+    cout<<"Factory Scaling"<<endl;
+    FactoryScalingDemo();
+    cout<<endl<<endl;
+    cout<<"Random Streams"<<endl;
+    RandomDemo();
+    cout<<endl<<endl;
     cout<<"Builder + Prototype"<<endl;
     BuilderPrototypeDemo();
     cout<<endl<<endl;
+    cout<<"Attachment IDs"<<endl;
+    AttachmentIdDemo();
+    cout<<endl<<endl;
+    cout<<"Copy-on-write Clones"<<endl;
+    CowCloneDemo();
+    cout<<endl<<endl;
+    cout<<"Preset Registry"<<endl;
+    PresetRegistryDemo();
+    cout<<endl<<endl;
+    cout<<"Loadout Generator"<<endl;
+    LoadoutGeneratorDemo();
+    cout<<endl<<endl;
     cout<<"Singleton"<<endl;
     SingletonDemo();
 
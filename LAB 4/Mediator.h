@@ -68,7 +68,7 @@ public:
         ammo--;
         mediator->notify(this, "Gun_Fire");
 
-        bool jam = rand()%2;
+        bool jam = randomBelow(2);
         if(jam)
             mediator->notify(this, "Gun_Jammed");
 
@@ -0,0 +1,70 @@
+#ifndef LAB_4_RANDOM_H
+#define LAB_4_RANDOM_H
+
+#include <cstdint>
+#include <limits>
+
+
+//The part of LAB 2/Random.h this lab uses: xoshiro256++ and randomBelow, replacing rand().
+//LAB 4 never seeded rand(), so every run uses the same fixed seed.
+
+uint64_t rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+//SplitMix64 step: turns any seed, even 0 or 1, into a well mixed 64-bit value
+uint64_t splitMix64(uint64_t& state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+
+//xoshiro256++: 64-bit output, 256-bit state
+class Xoshiro256{
+private:
+    uint64_t s[4];
+
+public:
+    typedef uint64_t result_type;
+
+    explicit Xoshiro256(uint64_t seed = 0)
+    {
+        for (auto& word : s)
+            word = splitMix64(seed);
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return numeric_limits<result_type>::max(); }
+
+    result_type operator()()
+    {
+        uint64_t result = rotl(s[0] + s[3], 23) + s[0];
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+};
+
+//Each thread has its own generator, so threads never share state
+Xoshiro256& threadRandom()
+{
+    thread_local Xoshiro256 gen(0x5EEDULL);
+    return gen;
+}
+
+//Unbiased enough for game use: multiply-shift of 32 random bits, no modulo
+uint32_t randomBelow(uint32_t n)
+{
+    return uint32_t((uint64_t(uint32_t(threadRandom()() >> 32)) * n) >> 32);
+}
+
+#endif //LAB_4_RANDOM_H
@@ -3,6 +3,7 @@
 
 using namespace std;
 
+#include "Random.h"
 #include "Strategy.h"
 #include "Observer.h"
 #include "Mediator.h"